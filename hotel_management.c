@@ -1,771 +1,4751 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-#include <mysql/mysql.h>
-
-// 房间类型枚举
-typedef enum {
-    STANDARD_SINGLE = 1,    // 标准单人间
-    STANDARD_DOUBLE,        // 标准双人间
-    DELUXE_SINGLE,          // 豪华单人间
-    DELUXE_DOUBLE,          // 豪华双人间
-    SUITE                   // 套房
-} RoomType;
-
-// 房间状态枚举
-typedef enum {
-    AVAILABLE = 0,          // 空闲
-    OCCUPIED,               // 已入住
-    CLEANING,               // 清洁中
-    MAINTENANCE             // 维修中
-} RoomStatus;
-
-// 客人信息结构体
-typedef struct Guest {
-    char name[50];          // 客人姓名
-    char id_card[20];       // 身份证号
-    char phone[15];         // 电话号码
-    char address[100];      // 地址
-} Guest;
-
-// 房间信息结构体
-typedef struct Room {
-    int room_number;        // 房间号
-    RoomType type;          // 房间类型
-    RoomStatus status;      // 房间状态
-    float price_per_night;  // 每晚价格
-    Guest guest;            // 客人信息
-    time_t check_in_time;   // 入住时间
-    time_t check_out_time;  // 退房时间
-    int is_checked_out;     // 是否已退房
-    struct Room* next;      // 指向下一个房间的指针
-} Room;
-
-// 全局变量
-Room* head = NULL;          // 链表头指针
-MYSQL* mysql_conn = NULL;   // MySQL连接
-
-// 函数声明
-void init_database();
-void load_data_from_file();
-void save_data_to_file();
-void insert_to_database(Room* room);
-void delete_from_database(int room_number);
-void update_database(Room* room);
-
-// 菜单函数
-void show_main_menu();
-void show_room_type_menu();
-void show_room_status_menu();
-
-// 核心功能函数
-void register_guest();
-void check_out();
-void search_info();
-void statistics();
-void sort_rooms();
-void display_all_rooms();
-void display_available_rooms();
-
-// 工具函数
-Room* create_room(int room_number, RoomType type, float price);
-void add_room_to_list(Room* new_room);
-Room* find_room(int room_number);
-void delete_room_from_list(int room_number);
-void free_room_list();
-char* get_room_type_name(RoomType type);
-char* get_room_status_name(RoomStatus status);
-void print_room_info(Room* room);
-void print_guest_info(Guest* guest);
-
-int main() {
-    printf("=== 酒店前台信息管理系统 ===\n");
-    
-    // 初始化数据库连接
-    init_database();
-    
-    // 从文件加载数据
-    load_data_from_file();
-    
-    int choice;
-    do {
-        show_main_menu();
-        printf("请输入您的选择: ");
-        scanf("%d", &choice);
-        getchar(); // 清除缓冲区
-        
-        switch (choice) {
-            case 1:
-                register_guest();
-                break;
-            case 2:
-                check_out();
-                break;
-            case 3:
-                search_info();
-                break;
-            case 4:
-                statistics();
-                break;
-            case 5:
-                sort_rooms();
-                break;
-            case 6:
-                display_all_rooms();
-                break;
-            case 7:
-                display_available_rooms();
-                break;
-            case 0:
-                printf("感谢使用酒店管理系统！\n");
-                break;
-            default:
-                printf("无效选择，请重新输入！\n");
-        }
-    } while (choice != 0);
-    
-    // 保存数据到文件
-    save_data_to_file();
-    
-    // 清理内存
-    free_room_list();
-    
-    // 关闭数据库连接
-    if (mysql_conn) {
-        mysql_close(mysql_conn);
-    }
-    
-    return 0;
-}
-
-// 初始化数据库连接
-void init_database() {
-    mysql_conn = mysql_init(NULL);
-    if (mysql_conn == NULL) {
-        printf("MySQL初始化失败\n");
-        return;
-    }
-    
-    if (mysql_real_connect(mysql_conn, "localhost", "root", "password", 
-                          "hotel_db", 3306, NULL, 0) == NULL) {
-        printf("数据库连接失败: %s\n", mysql_error(mysql_conn));
-        return;
-    }
-    
-    printf("数据库连接成功\n");
-}
-
-// 从文件加载数据
-void load_data_from_file() {
-    FILE* file = fopen("occupied_rooms.dat", "rb");
-    if (file == NULL) {
-        printf("未找到入住信息文件，将创建新文件\n");
-        return;
-    }
-    
-    Room temp_room;
-    while (fread(&temp_room, sizeof(Room), 1, file) == 1) {
-        Room* new_room = create_room(temp_room.room_number, temp_room.type, temp_room.price_per_night);
-        if (new_room) {
-            new_room->status = temp_room.status;
-            new_room->guest = temp_room.guest;
-            new_room->check_in_time = temp_room.check_in_time;
-            new_room->check_out_time = temp_room.check_out_time;
-            new_room->is_checked_out = temp_room.is_checked_out;
-            add_room_to_list(new_room);
-        }
-    }
-    
-    fclose(file);
-    printf("数据加载完成\n");
-}
-
-// 保存数据到文件
-void save_data_to_file() {
-    FILE* occupied_file = fopen("occupied_rooms.dat", "wb");
-    FILE* checked_out_file = fopen("checked_out_rooms.dat", "ab");
-    
-    if (occupied_file == NULL || checked_out_file == NULL) {
-        printf("文件操作失败\n");
-        return;
-    }
-    
-    Room* current = head;
-    while (current != NULL) {
-        if (current->is_checked_out) {
-            // 保存退房信息
-            fwrite(current, sizeof(Room), 1, checked_out_file);
-            // 从数据库中删除
-            delete_from_database(current->room_number);
-        } else {
-            // 保存未退房信息
-            fwrite(current, sizeof(Room), 1, occupied_file);
-            // 更新数据库
-            update_database(current);
-        }
-        current = current->next;
-    }
-    
-    fclose(occupied_file);
-    fclose(checked_out_file);
-    printf("数据保存完成\n");
-}
-
-// 显示主菜单
-void show_main_menu() {
-    printf("\n=== 主菜单 ===\n");
-    printf("1. 客人登记\n");
-    printf("2. 客人结账\n");
-    printf("3. 信息查找\n");
-    printf("4. 统计功能\n");
-    printf("5. 排序功能\n");
-    printf("6. 显示所有房间\n");
-    printf("7. 显示空闲房间\n");
-    printf("0. 退出系统\n");
-    printf("================\n");
-}
-
-// 显示房间类型菜单
-void show_room_type_menu() {
-    printf("\n=== 房间类型 ===\n");
-    printf("1. 标准单人间\n");
-    printf("2. 标准双人间\n");
-    printf("3. 豪华单人间\n");
-    printf("4. 豪华双人间\n");
-    printf("5. 套房\n");
-    printf("================\n");
-}
-
-// 创建新房间
-Room* create_room(int room_number, RoomType type, float price) {
-    Room* new_room = (Room*)malloc(sizeof(Room));
-    if (new_room == NULL) {
-        printf("内存分配失败\n");
-        return NULL;
-    }
-    
-    new_room->room_number = room_number;
-    new_room->type = type;
-    new_room->status = AVAILABLE;
-    new_room->price_per_night = price;
-    new_room->is_checked_out = 0;
-    new_room->next = NULL;
-    
-    return new_room;
-}
-
-// 将房间添加到链表
-void add_room_to_list(Room* new_room) {
-    if (head == NULL) {
-        head = new_room;
-    } else {
-        Room* current = head;
-        while (current->next != NULL) {
-            current = current->next;
-        }
-        current->next = new_room;
-    }
-}
-
-// 查找房间
-Room* find_room(int room_number) {
-    Room* current = head;
-    while (current != NULL) {
-        if (current->room_number == room_number) {
-            return current;
-        }
-        current = current->next;
-    }
-    return NULL;
-}
-
-// 从链表中删除房间
-void delete_room_from_list(int room_number) {
-    if (head == NULL) return;
-    
-    if (head->room_number == room_number) {
-        Room* temp = head;
-        head = head->next;
-        free(temp);
-        return;
-    }
-    
-    Room* current = head;
-    while (current->next != NULL && current->next->room_number != room_number) {
-        current = current->next;
-    }
-    
-    if (current->next != NULL) {
-        Room* temp = current->next;
-        current->next = temp->next;
-        free(temp);
-    }
-}
-
-// 释放链表内存
-void free_room_list() {
-    Room* current = head;
-    while (current != NULL) {
-        Room* temp = current;
-        current = current->next;
-        free(temp);
-    }
-    head = NULL;
-}
-
-// 获取房间类型名称
-char* get_room_type_name(RoomType type) {
-    switch (type) {
-        case STANDARD_SINGLE: return "标准单人间";
-        case STANDARD_DOUBLE: return "标准双人间";
-        case DELUXE_SINGLE: return "豪华单人间";
-        case DELUXE_DOUBLE: return "豪华双人间";
-        case SUITE: return "套房";
-        default: return "未知类型";
-    }
-}
-
-// 获取房间状态名称
-char* get_room_status_name(RoomStatus status) {
-    switch (status) {
-        case AVAILABLE: return "空闲";
-        case OCCUPIED: return "已入住";
-        case CLEANING: return "清洁中";
-        case MAINTENANCE: return "维修中";
-        default: return "未知状态";
-    }
-}
-
-// 打印房间信息
-void print_room_info(Room* room) {
-    printf("\n房间号: %d\n", room->room_number);
-    printf("房间类型: %s\n", get_room_type_name(room->type));
-    printf("房间状态: %s\n", get_room_status_name(room->status));
-    printf("每晚价格: %.2f元\n", room->price_per_night);
-    
-    if (room->status == OCCUPIED) {
-        printf("入住时间: %s", ctime(&room->check_in_time));
-        print_guest_info(&room->guest);
-    }
-}
-
-// 打印客人信息
-void print_guest_info(Guest* guest) {
-    printf("客人姓名: %s\n", guest->name);
-    printf("身份证号: %s\n", guest->id_card);
-    printf("电话号码: %s\n", guest->phone);
-    printf("地址: %s\n", guest->address);
-}
-
-// 客人登记功能
-void register_guest() {
-    printf("\n=== 客人登记 ===\n");
-    
-    // 显示房间类型
-    show_room_type_menu();
-    
-    int type_choice;
-    printf("请选择房间类型: ");
-    scanf("%d", &type_choice);
-    getchar();
-    
-    if (type_choice < 1 || type_choice > 5) {
-        printf("无效的房间类型选择\n");
-        return;
-    }
-    
-    RoomType selected_type = (RoomType)type_choice;
-    
-    // 显示该类型的空闲房间
-    printf("\n该类型的空闲房间:\n");
-    Room* current = head;
-    int found = 0;
-    
-    while (current != NULL) {
-        if (current->type == selected_type && current->status == AVAILABLE) {
-            printf("房间号: %d, 价格: %.2f元/晚\n", 
-                   current->room_number, current->price_per_night);
-            found = 1;
-        }
-        current = current->next;
-    }
-    
-    if (!found) {
-        printf("该类型没有空闲房间\n");
-        return;
-    }
-    
-    // 选择房间
-    int room_number;
-    printf("请输入要入住的房间号: ");
-    scanf("%d", &room_number);
-    getchar();
-    
-    Room* selected_room = find_room(room_number);
-    if (selected_room == NULL) {
-        printf("房间不存在\n");
-        return;
-    }
-    
-    if (selected_room->status != AVAILABLE) {
-        printf("该房间不可用\n");
-        return;
-    }
-    
-    // 输入客人信息
-    printf("请输入客人信息:\n");
-    printf("姓名: ");
-    scanf("%s", selected_room->guest.name);
-    getchar();
-    
-    printf("身份证号: ");
-    scanf("%s", selected_room->guest.id_card);
-    getchar();
-    
-    printf("电话号码: ");
-    scanf("%s", selected_room->guest.phone);
-    getchar();
-    
-    printf("地址: ");
-    scanf("%s", selected_room->guest.address);
-    getchar();
-    
-    // 更新房间状态
-    selected_room->status = OCCUPIED;
-    selected_room->check_in_time = time(NULL);
-    selected_room->is_checked_out = 0;
-    
-    // 插入数据库
-    insert_to_database(selected_room);
-    
-    printf("登记成功！\n");
-    print_room_info(selected_room);
-}
-
-// 结账功能
-void check_out() {
-    printf("\n=== 客人结账 ===\n");
-    
-    int room_number;
-    printf("请输入要结账的房间号: ");
-    scanf("%d", &room_number);
-    getchar();
-    
-    Room* room = find_room(room_number);
-    if (room == NULL) {
-        printf("房间不存在\n");
-        return;
-    }
-    
-    if (room->status != OCCUPIED) {
-        printf("该房间没有客人入住\n");
-        return;
-    }
-    
-    // 显示房间信息供确认
-    printf("房间信息确认:\n");
-    print_room_info(room);
-    
-    char confirm;
-    printf("确认结账？(y/n): ");
-    scanf("%c", &confirm);
-    getchar();
-    
-    if (confirm == 'y' || confirm == 'Y') {
-        room->status = CLEANING;
-        room->check_out_time = time(NULL);
-        room->is_checked_out = 1;
-        
-        // 更新数据库
-        update_database(room);
-        
-        printf("结账成功！房间已标记为清洁中\n");
-    } else {
-        printf("结账已取消\n");
-    }
-}
-
-// 信息查找功能
-void search_info() {
-    printf("\n=== 信息查找 ===\n");
-    printf("1. 按房间号查找\n");
-    printf("2. 按客人姓名查找\n");
-    printf("3. 按身份证号查找\n");
-    
-    int choice;
-    printf("请选择查找方式: ");
-    scanf("%d", &choice);
-    getchar();
-    
-    switch (choice) {
-        case 1: {
-            int room_number;
-            printf("请输入房间号: ");
-            scanf("%d", &room_number);
-            getchar();
-            
-            Room* room = find_room(room_number);
-            if (room != NULL) {
-                print_room_info(room);
-            } else {
-                printf("未找到该房间\n");
-            }
-            break;
-        }
-        case 2: {
-            char name[50];
-            printf("请输入客人姓名: ");
-            scanf("%s", name);
-            getchar();
-            
-            Room* current = head;
-            int found = 0;
-            while (current != NULL) {
-                if (strcmp(current->guest.name, name) == 0) {
-                    print_room_info(current);
-                    found = 1;
-                }
-                current = current->next;
-            }
-            
-            if (!found) {
-                printf("未找到该客人\n");
-            }
-            break;
-        }
-        case 3: {
-            char id_card[20];
-            printf("请输入身份证号: ");
-            scanf("%s", id_card);
-            getchar();
-            
-            Room* current = head;
-            int found = 0;
-            while (current != NULL) {
-                if (strcmp(current->guest.id_card, id_card) == 0) {
-                    print_room_info(current);
-                    found = 1;
-                }
-                current = current->next;
-            }
-            
-            if (!found) {
-                printf("未找到该身份证号\n");
-            }
-            break;
-        }
-        default:
-            printf("无效选择\n");
-    }
-}
-
-// 统计功能
-void statistics() {
-    printf("\n=== 统计信息 ===\n");
-    
-    int total_rooms = 0;
-    int occupied_rooms = 0;
-    int available_rooms = 0;
-    int cleaning_rooms = 0;
-    int maintenance_rooms = 0;
-    float total_revenue = 0.0;
-    
-    Room* current = head;
-    while (current != NULL) {
-        total_rooms++;
-        
-        switch (current->status) {
-            case OCCUPIED:
-                occupied_rooms++;
-                break;
-            case AVAILABLE:
-                available_rooms++;
-                break;
-            case CLEANING:
-                cleaning_rooms++;
-                break;
-            case MAINTENANCE:
-                maintenance_rooms++;
-                break;
-        }
-        
-        if (current->status == OCCUPIED) {
-            time_t now = time(NULL);
-            int days = (int)((now - current->check_in_time) / (24 * 3600));
-            total_revenue += current->price_per_night * days;
-        }
-        
-        current = current->next;
-    }
-    
-    printf("总房间数: %d\n", total_rooms);
-    printf("已入住房间: %d\n", occupied_rooms);
-    printf("空闲房间: %d\n", available_rooms);
-    printf("清洁中房间: %d\n", cleaning_rooms);
-    printf("维修中房间: %d\n", maintenance_rooms);
-    printf("当前收入: %.2f元\n", total_revenue);
-    
-    if (total_rooms > 0) {
-        printf("入住率: %.2f%%\n", (float)occupied_rooms / total_rooms * 100);
-    }
-}
-
-// 排序功能
-void sort_rooms() {
-    printf("\n=== 排序功能 ===\n");
-    printf("1. 按房间号排序\n");
-    printf("2. 按价格排序\n");
-    printf("3. 按入住时间排序\n");
-    
-    int choice;
-    printf("请选择排序方式: ");
-    scanf("%d", &choice);
-    getchar();
-    
-    if (head == NULL || head->next == NULL) {
-        printf("房间数量不足，无需排序\n");
-        return;
-    }
-    
-    int swapped;
-    Room* ptr1;
-    Room* lptr = NULL;
-    
-    do {
-        swapped = 0;
-        ptr1 = head;
-        
-        while (ptr1->next != lptr) {
-            int should_swap = 0;
-            
-            switch (choice) {
-                case 1: // 按房间号排序
-                    should_swap = ptr1->room_number > ptr1->next->room_number;
-                    break;
-                case 2: // 按价格排序
-                    should_swap = ptr1->price_per_night > ptr1->next->price_per_night;
-                    break;
-                case 3: // 按入住时间排序
-                    should_swap = ptr1->check_in_time > ptr1->next->check_in_time;
-                    break;
-                default:
-                    printf("无效选择\n");
-                    return;
-            }
-            
-            if (should_swap) {
-                // 交换房间信息
-                Room temp = *ptr1;
-                ptr1->room_number = ptr1->next->room_number;
-                ptr1->type = ptr1->next->type;
-                ptr1->status = ptr1->next->status;
-                ptr1->price_per_night = ptr1->next->price_per_night;
-                ptr1->guest = ptr1->next->guest;
-                ptr1->check_in_time = ptr1->next->check_in_time;
-                ptr1->check_out_time = ptr1->next->check_out_time;
-                ptr1->is_checked_out = ptr1->next->is_checked_out;
-                
-                ptr1->next->room_number = temp.room_number;
-                ptr1->next->type = temp.type;
-                ptr1->next->status = temp.status;
-                ptr1->next->price_per_night = temp.price_per_night;
-                ptr1->next->guest = temp.guest;
-                ptr1->next->check_in_time = temp.check_in_time;
-                ptr1->next->check_out_time = temp.check_out_time;
-                ptr1->next->is_checked_out = temp.is_checked_out;
-                
-                swapped = 1;
-            }
-            ptr1 = ptr1->next;
-        }
-        lptr = ptr1;
-    } while (swapped);
-    
-    printf("排序完成！\n");
-    display_all_rooms();
-}
-
-// 显示所有房间
-void display_all_rooms() {
-    printf("\n=== 所有房间信息 ===\n");
-    
-    if (head == NULL) {
-        printf("暂无房间信息\n");
-        return;
-    }
-    
-    Room* current = head;
-    while (current != NULL) {
-        print_room_info(current);
-        current = current->next;
-    }
-}
-
-// 显示空闲房间
-void display_available_rooms() {
-    printf("\n=== 空闲房间信息 ===\n");
-    
-    Room* current = head;
-    int found = 0;
-    
-    while (current != NULL) {
-        if (current->status == AVAILABLE) {
-            printf("房间号: %d, 类型: %s, 价格: %.2f元/晚\n", 
-                   current->room_number, 
-                   get_room_type_name(current->type), 
-                   current->price_per_night);
-            found = 1;
-        }
-        current = current->next;
-    }
-    
-    if (!found) {
-        printf("暂无空闲房间\n");
-    }
-}
-
-// 插入数据到数据库
-void insert_to_database(Room* room) {
-    if (mysql_conn == NULL) return;
-    
-    char query[1024];
-    sprintf(query, 
-        "INSERT INTO rooms (room_number, room_type, status, price_per_night, "
-        "guest_name, id_card, phone, address, check_in_time) "
-        "VALUES (%d, %d, %d, %.2f, '%s', '%s', '%s', '%s', %ld)",
-        room->room_number, room->type, room->status, room->price_per_night,
-        room->guest.name, room->guest.id_card, room->guest.phone, 
-        room->guest.address, room->check_in_time);
-    
-    if (mysql_query(mysql_conn, query) != 0) {
-        printf("数据库插入失败: %s\n", mysql_error(mysql_conn));
-    }
-}
-
-// 从数据库删除数据
-void delete_from_database(int room_number) {
-    if (mysql_conn == NULL) return;
-    
-    char query[256];
-    sprintf(query, "DELETE FROM rooms WHERE room_number = %d", room_number);
-    
-    if (mysql_query(mysql_conn, query) != 0) {
-        printf("数据库删除失败: %s\n", mysql_error(mysql_conn));
-    }
-}
-
-// 更新数据库
-void update_database(Room* room) {
-    if (mysql_conn == NULL) return;
-    
-    char query[1024];
-    sprintf(query, 
-        "UPDATE rooms SET status = %d, check_out_time = %ld, is_checked_out = %d "
-        "WHERE room_number = %d",
-        room->status, room->check_out_time, room->is_checked_out, room->room_number);
-    
-    if (mysql_query(mysql_conn, query) != 0) {
-        printf("数据库更新失败: %s\n", mysql_error(mysql_conn));
-    }
-} 
\ No newline at end of file
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <mysql/mysql.h>
+
+// 房间类型枚举
+typedef enum {
+    STANDARD_SINGLE = 1,    // 标准单人间
+    STANDARD_DOUBLE,        // 标准双人间
+    DELUXE_SINGLE,          // 豪华单人间
+    DELUXE_DOUBLE,          // 豪华双人间
+    SUITE                   // 套房
+} RoomType;
+
+// 房间状态枚举
+typedef enum {
+    AVAILABLE = 0,          // 空闲
+    OCCUPIED,               // 已入住
+    CLEANING,               // 清洁中
+    MAINTENANCE             // 维修中
+} RoomStatus;
+
+// 客人信息结构体（输入和显示用，存储见GuestStore）
+typedef struct Guest {
+    char name[50];          // 客人姓名
+    char id_card[20];       // 身份证号
+    char phone[15];         // 电话号码
+    char address[100];      // 地址
+} Guest;
+
+// 智能锁状态
+typedef struct LockState {
+    char code[8];           // 开门密码，空串表示未设置
+    int failed_attempts;    // 当前窗口内失败次数
+    time_t window_start;    // 限流窗口开始时间
+} LockState;
+
+// 房间信息结构体
+typedef struct Room {
+    int room_number;        // 房间号
+    RoomType type;          // 房间类型
+    RoomStatus status;      // 房间状态
+    float price_per_night;  // 每晚价格
+    int guest_id;           // 客人编号，0表示无客人
+    time_t check_in_time;   // 入住时间
+    time_t check_out_time;  // 退房时间
+    time_t expected_check_out_time; // 预计退房时间
+    int is_checked_out;     // 是否已退房
+    LockState lock;         // 智能锁状态
+    int slot;               // 快照槽位（运行时分配）
+    unsigned int dirty;     // 待处理的修改标记（运行时使用）
+    struct Room* next;      // 指向下一个房间的指针
+} Room;
+
+// 房间号哈希索引（开放寻址，线性探测）
+typedef struct RoomIndex {
+    Room** slots;           // 槽位数组
+    int capacity;           // 槽位数（2的幂）
+    int count;              // 已用槽位数
+} RoomIndex;
+
+// 共享内存房间状态表（供后端等本机进程零拷贝只读访问）
+//
+// 布局: ShmHeader | ShmRoomSlot[SHM_ROOM_SLOTS] | ShmStatusEvent[SHM_EVENT_SLOTS]
+// 房间槽位是以room_number为键的开放寻址表，探测方式与find_room相同:
+//   i = (uint32)room_number * 2654435761 & (SHM_ROOM_SLOTS - 1)，线性探测到空槽(room_number == 0)为止
+// 读槽位(序列锁): s1 = seq(acquire)；s1为奇数则重试；复制字段；acquire栅栏；s2 = seq；s1 != s2则重试
+// 读事件: 读者自行保存游标c；当c < event_head时读取events[c % SHM_EVENT_SLOTS]，
+//   复制前后事件的seq都等于c + 1才有效，否则说明已被覆盖，应重新读取整张房间表
+#define SHM_NAME "/hotel_room_status"
+#define SHM_MAGIC 0x484F544CU       // "HOTL"
+#define SHM_VERSION 1
+#define SHM_ROOM_SLOTS 65536        // 房间槽位数（2的幂）
+#define SHM_EVENT_SLOTS 4096        // 状态变更事件环形缓冲区容量（2的幂）
+
+typedef struct ShmRoomSlot {
+    uint32_t seq;           // 序列锁，奇数表示正在写入
+    int32_t room_number;    // 房间号，0表示空槽
+    int32_t type;           // 房间类型
+    int32_t status;         // 房间状态
+    float price_per_night;  // 每晚价格
+    int32_t reserved;       // 保留
+    int64_t check_in_time;  // 入住时间
+} ShmRoomSlot;
+
+typedef struct ShmStatusEvent {
+    uint64_t seq;           // 事件序号（从1开始），为0表示正在写入
+    int32_t room_number;    // 房间号
+    int32_t old_status;     // 原状态
+    int32_t new_status;     // 新状态
+    int32_t reserved;       // 保留
+    int64_t timestamp;      // 变更时间
+} ShmStatusEvent;
+
+typedef struct ShmHeader {
+    uint32_t magic;         // SHM_MAGIC
+    uint32_t version;       // SHM_VERSION
+    uint32_t room_slots;    // SHM_ROOM_SLOTS
+    uint32_t event_slots;   // SHM_EVENT_SLOTS
+    int32_t engine_pid;     // 发布者进程号
+    uint32_t room_count;    // 已发布房间数
+    uint64_t event_head;    // 已发布事件总数
+} ShmHeader;
+
+typedef struct ShmSegment {
+    ShmHeader header;
+    ShmRoomSlot rooms[SHM_ROOM_SLOTS];
+    ShmStatusEvent events[SHM_EVENT_SLOTS];
+} ShmSegment;
+
+// 分层时间轮（秒级，4层×64槽，覆盖约194天）
+#define TW_LEVELS 4
+#define TW_BITS 6
+#define TW_SLOTS (1 << TW_BITS)
+#define TW_MASK (TW_SLOTS - 1)
+#define CLEANING_DURATION (30 * 60)     // 退房后清洁时长（秒）
+#define MAINTENANCE_RETRY (60 * 60)     // 维修开始时房间有客，顺延时长（秒）
+#define CHECK_OUT_HOUR 12               // 规定退房时刻
+
+// 定时任务类型
+typedef enum {
+    TIMER_CLEANING_DONE,    // 清洁完成：清洁中 -> 空闲
+    TIMER_MAINTENANCE_START,// 维修开始：-> 维修中
+    TIMER_MAINTENANCE_END,  // 维修结束：维修中 -> 空闲
+    TIMER_OVERSTAY,         // 超时未退房提醒
+    TIMER_AUTOSAVE          // 自动保存修改过的房间（不属于任何房间）
+} TimerKind;
+
+// 定时任务节点（双向链表挂在时间轮槽位上）
+typedef struct Timer {
+    time_t expires;         // 到期时间
+    TimerKind kind;         // 任务类型
+    int room_number;        // 房间号
+    time_t stamp;           // 调度时的房间时间戳，到期时用于判断任务是否仍有效
+    int duration;           // 维修时长（秒）
+    struct Timer* prev;
+    struct Timer* next;
+} Timer;
+
+typedef struct TimerWheel {
+    time_t current;                         // 下一个待处理的秒
+    Timer* slots[TW_LEVELS][TW_SLOTS];      // 各层槽位
+    int pending;                            // 待触发任务数
+} TimerWheel;
+
+// 团队入住
+#define ROOM_TYPE_COUNT 5           // 房间类型数
+#define ROOM_FLOOR(n) ((n) / 100)   // 楼层由房间号百位决定
+
+// 列式导出
+//
+// 文件布局（整数均为小端，varint为LEB128，zigzag用于有符号差值）:
+//   "HCOL" | u8 版本 | 类型字典 | 状态字典 | u8 列数 | 列名(varint长度+字节)...
+//   行组...: varint 行数 | 每列: u32 字节数 + 列数据
+//   结尾: u32 0（行数为0的行组标记）| u64 总行数 | "HCOL"
+// 字典: u8 项数 | 每项 u8 编码 + 名称(varint长度+字节)
+// 每个行组内的差值编码从0重新开始，可独立解码
+#define EXPORT_MAGIC "HCOL"
+#define EXPORT_VERSION 1
+#define EXPORT_ROW_GROUP 8192       // 每个行组的行数
+#define EXPORT_IO_BUFFER (1 << 20)  // 文件写缓冲区大小
+
+typedef enum {
+    COL_SOURCE = 0,         // u8: 0当前房间表，1退房归档
+    COL_ROOM_NUMBER,        // zigzag差值varint
+    COL_TYPE,               // u8字典编码
+    COL_STATUS,             // u8字典编码
+    COL_PRICE_CENTS,        // varint，单位分
+    COL_CHECK_IN_TIME,      // zigzag差值varint
+    COL_CHECK_OUT_TIME,     // zigzag差值varint
+    COL_GUEST_NAME,         // varint长度+字节
+    COL_ID_CARD,            // varint长度+字节
+    EXPORT_COLUMNS
+} ExportColumn;
+
+typedef struct ExportBuffer {
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+} ExportBuffer;
+
+// 智能锁
+#define LOCK_CODE_LENGTH 6          // 开门密码位数
+#define LOCK_MAX_FAILURES 5         // 限流窗口内允许的失败次数
+#define LOCK_WINDOW (5 * 60)        // 限流窗口（秒）
+#define LOCK_AUDIT_CAPACITY 4096    // 审计队列容量
+#define LOCK_AUDIT_BATCH 256        // 单条INSERT写入的最大记录数
+#define LOCK_AUDIT_INTERVAL 1       // 审计记录刷新间隔（秒）
+
+// 验证结果
+typedef enum {
+    LOCK_OK = 0,            // 密码正确
+    LOCK_WRONG_CODE,        // 密码错误
+    LOCK_NOT_OCCUPIED,      // 房间未入住
+    LOCK_NO_ROOM,           // 房间不存在
+    LOCK_RATE_LIMITED       // 失败次数过多，暂时拒绝
+} LockResult;
+
+// 审计操作类型，对应lock_operations.operation_type
+typedef enum {
+    LOCK_OP_SET = 0,        // 设置密码
+    LOCK_OP_VERIFY,         // 验证密码
+    LOCK_OP_RESET           // 重置密码
+} LockOperation;
+
+typedef struct LockAuditRecord {
+    int room_number;
+    LockOperation operation;
+    int success;
+    time_t timestamp;
+} LockAuditRecord;
+
+// 审计记录队列，由后台线程批量写入数据库
+typedef struct LockAuditQueue {
+    LockAuditRecord records[LOCK_AUDIT_CAPACITY];
+    int head;               // 下一条待写出记录
+    int count;              // 队列中的记录数
+    long dropped;           // 队列满时丢弃的记录数
+    int running;            // 后台线程是否运行
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} LockAuditQueue;
+
+// 客人表：按身份证号去重，字符串集中存放在arena中，房间和退房记录只保存guest_id
+#define GUEST_FILE_MAGIC 0x54534755U    // "UGST"
+
+typedef struct GuestRecord {
+    uint32_t name;          // 姓名在arena中的偏移
+    uint32_t id_card;       // 身份证号偏移
+    uint32_t phone;         // 电话偏移
+    uint32_t address;       // 地址偏移
+    int stay_count;         // 历史入住次数
+    int32_t last_stay;      // 最近一条退房记录在归档中的序号，-1表示无
+} GuestRecord;
+
+typedef struct GuestStore {
+    GuestRecord* guests;    // guest_id = 下标 + 1
+    int count;
+    int capacity;
+    char* arena;            // 以'\0'结尾的字符串依次存放
+    size_t arena_size;
+    size_t arena_capacity;
+    int* id_index;          // 身份证号哈希 -> guest_id，0为空槽
+    int index_capacity;
+    int modified;           // 自上次保存后是否有修改
+} GuestStore;
+
+// 退房归档记录（checked_out_rooms.dat）
+typedef struct StayRecord {
+    int room_number;        // 房间号
+    RoomType type;          // 房间类型
+    float price_per_night;  // 每晚价格
+    int guest_id;           // 客人编号
+    time_t check_in_time;   // 入住时间
+    time_t check_out_time;  // 退房时间
+    int32_t prev_stay;      // 同一客人的上一条记录序号，-1表示无
+} StayRecord;
+
+// 写时复制快照：房间按槽位分页，生成快照时只复制自上次快照以来被修改过的页，
+// 未修改的页在新旧快照间共享。快照只读，可在任意线程读取和释放
+#define SNAPSHOT_PAGE_SHIFT 6
+#define SNAPSHOT_PAGE_SIZE (1 << SNAPSHOT_PAGE_SHIFT)   // 每页房间数
+
+typedef struct RoomPage {
+    int refcount;                       // 引用该页的快照数
+    Room rooms[SNAPSHOT_PAGE_SIZE];     // room_number为0表示空槽
+} RoomPage;
+
+typedef struct RoomSnapshot {
+    int refcount;           // 引用计数
+    time_t taken_at;        // 生成时间
+    int slot_count;         // 槽位数
+    int room_count;         // 房间数
+    int page_count;         // 页数
+    RoomPage** pages;       // 页数组
+} RoomSnapshot;
+
+// 槽位表：slot -> 房间，并记录各页自上次快照后是否被修改
+typedef struct SlotTable {
+    Room** rooms;           // 槽位对应的房间，删除后为NULL
+    int count;              // 已分配槽位数
+    int capacity;
+    unsigned char* page_dirty; // 每页一个修改标记
+    int room_count;         // 当前房间数
+    RoomSnapshot* latest;   // 最近一次生成的快照（持有一个引用）
+} SlotTable;
+
+// 夜审与计费：金额一律用整数分（定点数）计算，避免浮点误差
+#define LATE_CHECK_OUT_HOUR 18      // 超过规定退房时刻但早于该时刻加收半天房费，之后加收全天
+#define AUDIT_MAX_WORKERS 16        // 夜审最大工作线程数
+
+typedef int64_t Money;              // 金额，单位分
+
+// 入账类型
+typedef enum {
+    POSTING_ROOM_CHARGE = 1,        // 夜审计提的当晚房费
+    POSTING_SETTLEMENT              // 结账时的整笔账单
+} PostingKind;
+
+// 入账记录（postings.dat）
+typedef struct PostingRecord {
+    int32_t business_date;  // 营业日期 YYYYMMDD
+    int32_t room_number;    // 房间号
+    int32_t guest_id;       // 客人编号
+    int32_t kind;           // PostingKind
+    int64_t amount;         // 金额（分）
+    int64_t posted_at;      // 入账时间
+} PostingRecord;
+
+// 夜审工作线程的输入与输出
+typedef struct AuditTask {
+    const RoomSnapshot* snapshot;
+    int first_page;         // 负责的页范围[first_page, last_page)
+    int last_page;
+    int32_t business_date;
+    time_t posted_at;
+    PostingRecord* postings; // 输出的入账记录
+    int count;
+    Money total;
+} AuditTask;
+
+// 有序索引（跳表）：价格索引包含所有房间，入住时间索引只包含已入住房间
+// 键相同时按房间号排序；范围查询和前k项均为O(log n + k)
+#define SKIPLIST_MAX_LEVEL 24
+
+typedef struct SkipNode {
+    int64_t key;            // 排序键
+    Room* room;             // 对应房间
+    struct SkipNode* backward;  // 第0层前驱，用于降序遍历
+    int level;              // 层数
+    struct SkipNode* forward[]; // 各层后继
+} SkipNode;
+
+typedef struct SkipList {
+    SkipNode* head;         // 哨兵节点
+    SkipNode* tail;         // 第0层最后一个节点
+    int level;              // 当前最高层数
+    int count;              // 节点数
+    uint32_t seed;          // 随机层数种子
+} SkipList;
+
+// 修改跟踪：Room.dirty中每一位对应一个修改集合，防止同一房间重复加入
+#define DIRTY_JOURNAL 0x1           // 待发送给备机
+#define DIRTY_FILE 0x2              // 待写入occupied_rooms.dat
+#define DIRTY_DB 0x4                // 待同步到存储后端
+#define AUTOSAVE_INTERVAL (5 * 60)  // 自动保存间隔（秒）
+
+typedef struct ChangeSet {
+    Room** rooms;           // 自上次处理后被修改的房间
+    int count;
+    int capacity;
+    unsigned int bit;       // 对应的Room.dirty标记位
+} ChangeSet;
+
+// 增量保存状态
+typedef struct SaveState {
+    ChangeSet file_changes; // 待写入快照文件的房间
+    ChangeSet db_changes;   // 待同步到存储后端的房间
+    int* freed_slots;       // 已删除房间的槽位，保存时写入空记录
+    int freed_count;
+    int freed_capacity;
+    int layout_valid;       // 快照文件第i条记录对应槽位i时才能原地更新
+} SaveState;
+
+// 日志复制（热备）：主机通过本地套接字把房间修改后的完整镜像发给备机
+// 备机用 --standby 启动，应用到自己的内存房间表，可随时提升为主机
+#define JOURNAL_SOCKET_PATH "/tmp/hotel_journal.sock"
+#define JOURNAL_MAGIC 0x4C4E524AU   // "JRNL"
+#define JOURNAL_MAX_STANDBYS 4      // 最多连接的备机数
+#define JOURNAL_HEARTBEAT_MS 1000   // 心跳间隔（毫秒）
+
+typedef enum {
+    JOURNAL_UPSERT = 1,     // 房间镜像（不存在则创建）
+    JOURNAL_DELETE,         // 删除房间
+    JOURNAL_HEARTBEAT       // 心跳，携带主机当前LSN
+} JournalOp;
+
+// 日志记录：固定长度，主备使用同一程序，按内存布局直接传输
+typedef struct JournalRecord {
+    uint32_t magic;         // JOURNAL_MAGIC
+    uint32_t op;            // JournalOp
+    uint64_t lsn;           // 日志序号
+    int64_t sent_at_us;     // 主机发送时刻（微秒），用于计算复制延迟
+    Room room;              // 房间镜像，next/slot/dirty无意义
+    Guest guest;            // 房间对应客人信息（guest_id只在本机有效）
+} JournalRecord;
+
+// 主机端复制状态
+typedef struct Replication {
+    int listen_fd;          // 监听套接字，-1表示未启用
+    int standby_fds[JOURNAL_MAX_STANDBYS];
+    int standby_count;
+    uint64_t lsn;           // 最近发出的日志序号
+    ChangeSet changes;      // 自上次发送后被修改的房间
+    int64_t last_heartbeat_us;
+} Replication;
+
+// 备机端复制统计
+typedef struct StandbyStats {
+    uint64_t applied_lsn;   // 已应用的日志序号
+    uint64_t primary_lsn;   // 主机最近通告的日志序号
+    uint64_t records;       // 已应用记录数
+    int64_t last_lag_us;    // 最近一条记录的复制延迟
+    int64_t max_lag_us;     // 最大复制延迟
+    int64_t total_lag_us;   // 延迟总和，用于求平均
+    int64_t last_received_us; // 最近收到消息的时刻
+} StandbyStats;
+
+// 持久化后端：房间记录的存储层，启动时用 --storage=mysql|kv|memory 选择
+// occupied_rooms.dat快照对所有后端通用，后端负责快照之后的变更
+#define KV_STORE_PATH "hotel_store.kv"
+#define KV_STORE_MAGIC 0x4B565354U  // "KVST"
+
+typedef struct StorageBackend {
+    const char* name;
+    int (*open)();                          // 成功返回1
+    void (*close)();
+    int (*load)(time_t snapshot_time);      // 校正内存表，返回校正的房间数，不可用返回-1
+    void (*insert)(const Room* room);
+    void (*update)(const Room* room);
+    void (*remove)(int room_number);
+    void (*begin)();                        // 批量写入开始
+    void (*commit)();                       // 批量写入提交
+} StorageBackend;
+
+typedef enum {
+    KV_PUT = 1,             // 房间镜像
+    KV_DELETE               // 删除房间
+} KvOp;
+
+// 嵌入式键值存储的日志记录：以房间号为键，追加写入，加载时取每个键的最后一条
+typedef struct KvRecord {
+    uint32_t magic;         // KV_STORE_MAGIC
+    uint32_t op;            // KvOp
+    int64_t updated_at;     // 写入时间
+    Room room;              // 房间镜像，next/slot/dirty无意义
+    Guest guest;            // 客人信息（guest_id只在本机有效）
+} KvRecord;
+
+// 加载时记录在日志中的位置
+typedef struct KvEntry {
+    int room_number;
+    uint32_t op;
+    int64_t updated_at;
+    long seq;               // 记录序号，同一房间取最大者
+} KvEntry;
+
+typedef struct KvStore {
+    FILE* file;             // 追加写入的日志文件
+    int in_batch;           // 批量写入中，提交时再落盘
+    long records;           // 日志中的记录数
+} KvStore;
+
+// 入住率分析：多线程分段流式读取退房归档，按房型累计每天售出的间夜数
+#define ANALYTICS_MAX_WORKERS 16    // 分析最大工作线程数
+#define ANALYTICS_BLOCK 4096        // 每次读取的退房记录数
+#define ANALYTICS_HISTORY_DAYS 3653 // 分析的历史天数（约10年）
+#define FORECAST_DAYS 30            // 需求预测天数
+#define FORECAST_WEEKS 8            // 预测基线取最近几周同一星期几的平均值
+
+// 分析结果：天数均为本地日期自1970-01-01起的序号
+typedef struct OccupancyReport {
+    int base_day;           // nights中第0天
+    int days;               // 窗口天数，最后一天为今天
+    int first_day;          // 窗口内最早有入住记录的一天
+    int rooms[ROOM_TYPE_COUNT]; // 各房型房间数（当前房间表），下标为类型-1
+    uint32_t* nights;       // [(type - 1) * days + d]：当天售出间夜数
+    long stays;             // 扫描的退房记录数
+} OccupancyReport;
+
+// 分析工作线程的输入与输出
+typedef struct AnalyticsTask {
+    int fd;                 // checked_out_rooms.dat，各线程用pread共享
+    long first;             // 负责的记录范围[first, last)
+    long last;
+    int base_day;
+    int days;
+    long utc_offset;        // 本地时间相对UTC的偏移（秒）
+    int32_t* diff;          // 差分数组[(type - 1) * (days + 1) + d]
+    long stays;
+    int failed;
+} AnalyticsTask;
+
+// 全局变量
+Room* head = NULL;          // 链表头指针
+Room* tail = NULL;          // 链表尾指针
+RoomIndex room_index = {NULL, 0, 0}; // 房间号索引
+MYSQL* mysql_conn = NULL;   // MySQL连接
+const StorageBackend* storage = NULL; // 当前持久化后端
+KvStore kv_store = {NULL, 0, 0};      // 嵌入式键值存储
+ShmSegment* shm_segment = NULL; // 共享内存状态表
+TimerWheel timer_wheel;     // 定时任务时间轮
+GuestStore guest_store = {NULL, 0, 0, NULL, 0, 0, NULL, 0, 0}; // 客人表
+SlotTable slot_table = {NULL, 0, 0, NULL, 0, NULL}; // 快照槽位表
+SkipList price_index = {NULL, NULL, 0, 0, 1};       // 价格索引
+SkipList check_in_index = {NULL, NULL, 0, 0, 2};    // 入住时间索引
+Replication replication = {.listen_fd = -1, .changes = {.bit = DIRTY_JOURNAL}}; // 主机端复制状态
+SaveState save_state = {.file_changes = {.bit = DIRTY_FILE}, .db_changes = {.bit = DIRTY_DB}}; // 增量保存状态
+LockAuditQueue lock_audit = {.mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER}; // 智能锁审计队列
+
+// 函数声明
+MYSQL* connect_database();
+void init_database();
+void close_database();
+void load_data_from_file();
+int warm_start_from_database(time_t snapshot_time);
+void save_data_to_file();
+void insert_to_database(const Room* room);
+void delete_from_database(int room_number);
+void update_database(const Room* room);
+void begin_database_batch();
+void commit_database_batch();
+
+// 持久化后端
+const StorageBackend* find_storage(const char* name);
+void apply_room_image(const Room* image, const Guest* guest);
+
+// 共享内存状态发布
+void shm_init();
+void shm_close();
+void shm_publish_room(Room* room);
+void shm_publish_event(int room_number, RoomStatus old_status, RoomStatus new_status);
+void set_room_status(Room* room, RoomStatus status);
+
+// 定时任务
+void timer_init();
+void timer_free_all();
+void timer_schedule(TimerKind kind, int room_number, time_t expires, time_t stamp, int duration);
+void timer_advance(time_t now);
+void timer_fire(Timer* timer);
+void schedule_room_timers(Room* room);
+time_t compute_expected_check_out(time_t check_in_time, int nights);
+void schedule_maintenance();
+
+// 团队入住
+int assign_group_rooms(const int counts[ROOM_TYPE_COUNT], Room** assigned);
+void group_check_in();
+void save_occupied_snapshot();
+
+// 修改跟踪与增量保存
+void changeset_add(ChangeSet* set, Room* room);
+void changeset_remove(ChangeSet* set, Room* room);
+void changeset_clear(ChangeSet* set);
+void changeset_free(ChangeSet* set);
+void room_forget(Room* room);
+int save_changed_rooms();
+
+// 数据导出
+int export_rooms(const char* path, int csv);
+void export_data();
+
+// 智能锁
+void lock_assign_code(Room* room);
+void lock_clear_code(Room* room);
+LockResult verify_lock_code(int room_number, const char* code);
+void lock_audit_start();
+void lock_audit_stop();
+void lock_audit_push(int room_number, LockOperation operation, int success);
+void smart_lock_verify();
+
+// 客人表
+int guest_upsert(const Guest* guest);
+int guest_find(const char* id_card);
+const char* guest_name(int guest_id);
+void guest_get(int guest_id, Guest* out);
+void guest_store_load();
+void guest_store_save();
+void guest_store_free();
+void archive_stay(Room* room);
+void print_guest_history(int guest_id);
+
+// 快照
+void room_touch(Room* room);
+RoomSnapshot* snapshot_acquire();
+void snapshot_release(RoomSnapshot* snapshot);
+const Room* snapshot_room(const RoomSnapshot* snapshot, int slot);
+
+// 夜审与计费
+Money price_to_money(float price);
+void format_money(Money amount, char* buf, size_t size);
+Money compute_stay_charge(Money rate, time_t check_in_time, time_t check_out_time);
+int run_night_audit(time_t now, Money* total);
+void append_postings(const PostingRecord* postings, int count);
+void night_audit();
+
+// 有序索引
+void skiplist_insert(SkipList* list, int64_t key, Room* room);
+void skiplist_remove(SkipList* list, int64_t key, Room* room);
+SkipNode* skiplist_lower_bound(SkipList* list, int64_t key);
+void skiplist_free(SkipList* list);
+void ordered_index_add(Room* room);
+void ordered_index_remove(Room* room);
+void range_query();
+
+// 热备复制
+int64_t now_us();
+void replication_listen();
+void replication_accept();
+void replication_close();
+void journal_flush();
+void journal_heartbeat();
+void journal_delete(int room_number);
+void wait_for_input();
+void apply_journal_record(const JournalRecord* record);
+int run_standby();
+
+// 入住率分析
+int run_occupancy_analysis(time_t now, OccupancyReport* report);
+void print_occupancy_report(const OccupancyReport* report);
+void occupancy_analytics();
+
+// 菜单函数
+void show_main_menu();
+void show_room_type_menu();
+void show_room_status_menu();
+
+// 核心功能函数
+void register_guest();
+void check_out();
+void search_info();
+void statistics();
+void sort_rooms();
+void display_all_rooms();
+void display_available_rooms();
+
+// 工具函数
+Room* create_room(int room_number, RoomType type, float price);
+void add_room_to_list(Room* new_room);
+Room* find_room(int room_number);
+void delete_room_from_list(int room_number);
+void free_room_list();
+void index_insert(Room* room);
+void index_remove(int room_number);
+char* get_room_type_name(RoomType type);
+char* get_room_status_name(RoomStatus status);
+void print_room_info(const Room* room);
+void print_guest_info(int guest_id);
+
+int main(int argc, char* argv[]) {
+    printf("=== 酒店前台信息管理系统 ===\n");
+    
+    // 解析命令行：--standby 备机模式，--storage=名称 选择持久化后端
+    int standby = 0;
+    storage = find_storage("mysql");
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--standby") == 0) {
+            standby = 1;
+        } else if (strncmp(argv[i], "--storage=", 10) == 0) {
+            storage = find_storage(argv[i] + 10);
+            if (storage == NULL) {
+                printf("未知的存储后端: %s（可选 mysql、kv、memory）\n", argv[i] + 10);
+                return 1;
+            }
+        } else {
+            printf("未知参数: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    
+    // 备机模式：从主机复制房间表，直到被提升为主机或退出
+    if (standby) {
+        if (!run_standby()) {
+            free_room_list();
+            guest_store_free();
+            return 0;
+        }
+        printf("备机已提升为主机\n");
+    }
+    
+    // 打开持久化后端
+    init_database();
+    
+    // 从文件加载数据（提升后的备机已有完整房间表）
+    if (!standby) {
+        load_data_from_file();
+    }
+    
+    // 发布共享内存状态表
+    shm_init();
+    
+    // 启动智能锁审计线程
+    lock_audit_start();
+    
+    // 为清洁中、已入住的房间安排定时任务
+    timer_init();
+    for (Room* current = head; current != NULL; current = current->next) {
+        schedule_room_timers(current);
+    }
+    
+    // 定期保存修改过的房间
+    timer_schedule(TIMER_AUTOSAVE, 0, time(NULL) + AUTOSAVE_INTERVAL, 0, 0);
+    
+    // 菜单输入改为无缓冲，等待输入时poll才能准确判断是否有待读输入
+    setvbuf(stdin, NULL, _IONBF, 0);
+    
+    // 接受备机连接
+    replication_listen();
+    
+    int choice;
+    do {
+        timer_advance(time(NULL));
+        show_main_menu();
+        printf("请输入您的选择: ");
+        wait_for_input();
+        scanf("%d", &choice);
+        getchar(); // 清除缓冲区
+        
+        switch (choice) {
+            case 1:
+                register_guest();
+                break;
+            case 2:
+                check_out();
+                break;
+            case 3:
+                search_info();
+                break;
+            case 4:
+                statistics();
+                break;
+            case 5:
+                sort_rooms();
+                break;
+            case 6:
+                display_all_rooms();
+                break;
+            case 7:
+                display_available_rooms();
+                break;
+            case 8:
+                schedule_maintenance();
+                break;
+            case 9:
+                group_check_in();
+                break;
+            case 10:
+                export_data();
+                break;
+            case 11:
+                smart_lock_verify();
+                break;
+            case 12:
+                night_audit();
+                break;
+            case 13:
+                range_query();
+                break;
+            case 14:
+                occupancy_analytics();
+                break;
+            case 0:
+                printf("感谢使用酒店管理系统！\n");
+                break;
+            default:
+                printf("无效选择，请重新输入！\n");
+        }
+        
+        // 把本次操作的修改发给备机
+        journal_flush();
+    } while (choice != 0);
+    
+    // 保存数据到文件
+    save_data_to_file();
+    
+    // 写出剩余的智能锁审计记录
+    lock_audit_stop();
+    
+    // 撤销共享内存状态表
+    shm_close();
+    
+    // 断开备机
+    replication_close();
+    
+    // 关闭持久化后端（键值存储在此压缩，需在释放房间表之前）
+    close_database();
+    
+    // 清理内存
+    timer_free_all();
+    free_room_list();
+    guest_store_free();
+    
+    return 0;
+}
+
+// 打开当前持久化后端
+void init_database() {
+    if (storage->open()) {
+        printf("存储后端已就绪: %s\n", storage->name);
+    }
+}
+
+// 关闭当前持久化后端
+void close_database() {
+    storage->close();
+}
+
+// 建立一个新的数据库连接，失败返回NULL
+MYSQL* connect_database() {
+    MYSQL* conn = mysql_init(NULL);
+    if (conn == NULL) {
+        printf("MySQL初始化失败\n");
+        return NULL;
+    }
+    
+    // 连接参数可由环境变量覆盖
+    const char* host = getenv("HOTEL_DB_HOST");
+    const char* user = getenv("HOTEL_DB_USER");
+    const char* password = getenv("HOTEL_DB_PASSWORD");
+    const char* database = getenv("HOTEL_DB_NAME");
+    
+    if (mysql_real_connect(conn, host ? host : "localhost", user ? user : "root",
+                          password ? password : "password",
+                          database ? database : "hotel_db", 3306, NULL, 0) == NULL) {
+        printf("数据库连接失败: %s\n", mysql_error(conn));
+        mysql_close(conn);
+        return NULL;
+    }
+    
+    return conn;
+}
+
+// 从文件加载数据
+void load_data_from_file() {
+    time_t snapshot_time = 0;
+    
+    // 房间记录引用guest_id，需先加载客人表
+    guest_store_load();
+    
+    FILE* file = fopen("occupied_rooms.dat", "rb");
+    if (file == NULL) {
+        printf("未找到入住信息文件，尝试从数据库恢复\n");
+    } else {
+        struct stat st;
+        if (fstat(fileno(file), &st) == 0) {
+            snapshot_time = st.st_mtime;
+        }
+        
+        Room temp_room;
+        int records = 0;
+        while (fread(&temp_room, sizeof(Room), 1, file) == 1) {
+            records++;
+            if (temp_room.room_number <= 0) continue; // 已删除房间留下的空记录
+            
+            Room* new_room = create_room(temp_room.room_number, temp_room.type, temp_room.price_per_night);
+            if (new_room) {
+                new_room->status = temp_room.status;
+                new_room->guest_id = temp_room.guest_id;
+                new_room->check_in_time = temp_room.check_in_time;
+                new_room->check_out_time = temp_room.check_out_time;
+                new_room->expected_check_out_time = temp_room.expected_check_out_time;
+                new_room->lock = temp_room.lock;
+                new_room->is_checked_out = temp_room.is_checked_out;
+                add_room_to_list(new_room);
+            }
+        }
+        
+        fclose(file);
+        
+        // 没有空记录时文件中的位置与槽位一致，之后可以原地更新
+        save_state.layout_valid = slot_table.count == records;
+    }
+    
+    // 刚加载的房间与文件和存储后端一致，无需保存
+    changeset_clear(&save_state.file_changes);
+    changeset_clear(&save_state.db_changes);
+    
+    // 以快照时间为界，用存储后端中更新的记录校正内存表
+    int restored = storage->load(snapshot_time);
+    if (restored > 0) {
+        printf("从%s恢复/校正了 %d 个房间\n", storage->name, restored);
+    }
+    
+    printf("数据加载完成\n");
+}
+
+// 将数据库字段复制到定长缓冲区
+static void copy_field(char* dest, size_t size, const char* src) {
+    if (src == NULL) {
+        dest[0] = '\0';
+        return;
+    }
+    snprintf(dest, size, "%s", src);
+}
+
+// 从数据库流式读取房间状态（mysql_use_result逐行读取，不缓存整个结果集）
+// 快照中不存在的房间直接创建；数据库记录比快照新时覆盖内存中的记录
+// 返回创建或覆盖的房间数，数据库不可用时返回-1
+int warm_start_from_database(time_t snapshot_time) {
+    if (mysql_conn == NULL) return -1;
+    
+    const char* query =
+        "SELECT room_number, room_type, status, price_per_night, "
+        "guest_name, id_card, phone, address, check_in_time, "
+        "check_out_time, is_checked_out, UNIX_TIMESTAMP(updated_at) "
+        "FROM rooms";
+    
+    if (mysql_query(mysql_conn, query) != 0) {
+        printf("数据库读取失败: %s\n", mysql_error(mysql_conn));
+        return -1;
+    }
+    
+    MYSQL_RES* result = mysql_use_result(mysql_conn);
+    if (result == NULL) {
+        printf("数据库读取失败: %s\n", mysql_error(mysql_conn));
+        return -1;
+    }
+    
+    int applied = 0;
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result)) != NULL) {
+        if (row[0] == NULL) continue;
+        
+        int room_number = atoi(row[0]);
+        time_t updated_at = row[11] ? (time_t)atoll(row[11]) : 0;
+        Room* room = find_room(room_number);
+        
+        if (room != NULL && updated_at <= snapshot_time) {
+            continue; // 快照已是最新
+        }
+        
+        RoomType type = row[1] ? (RoomType)atoi(row[1]) : STANDARD_SINGLE;
+        float price = row[3] ? (float)atof(row[3]) : 0.0f;
+        if (room == NULL) {
+            room = create_room(room_number, type, price);
+            if (room == NULL) break;
+            add_room_to_list(room);
+        }
+        ordered_index_remove(room);
+        
+        room->type = type;
+        room->price_per_night = price;
+        room->status = row[2] ? (RoomStatus)atoi(row[2]) : AVAILABLE;
+        Guest guest;
+        copy_field(guest.name, sizeof(guest.name), row[4]);
+        copy_field(guest.id_card, sizeof(guest.id_card), row[5]);
+        copy_field(guest.phone, sizeof(guest.phone), row[6]);
+        copy_field(guest.address, sizeof(guest.address), row[7]);
+        room->guest_id = guest.id_card[0] != '\0' ? guest_upsert(&guest) : 0;
+        room->check_in_time = row[8] ? (time_t)atoll(row[8]) : 0;
+        room->check_out_time = row[9] ? (time_t)atoll(row[9]) : 0;
+        if (room->status != OCCUPIED) {
+            room->expected_check_out_time = 0;
+            memset(&room->lock, 0, sizeof(LockState));
+        }
+        room->is_checked_out = row[10] ? atoi(row[10]) : 0;
+        room_touch(room);
+        ordered_index_add(room);
+        applied++;
+    }
+    
+    // 必须读完所有行后才能在该连接上执行其他语句
+    if (mysql_errno(mysql_conn) != 0) {
+        printf("数据库读取中断: %s\n", mysql_error(mysql_conn));
+    }
+    mysql_free_result(result);
+    
+    return applied;
+}
+
+// 保存数据到文件（退房记录已在结账时归档）
+void save_data_to_file() {
+    int saved = save_changed_rooms();
+    if (saved >= 0) {
+        printf("数据保存完成（%d 个房间有修改）\n", saved);
+    }
+}
+
+// 只保存上次保存后修改过的房间：快照文件原地更新，存储后端只同步这些记录
+// 返回写入的房间数，失败返回-1
+int save_changed_rooms() {
+    int saved = save_state.file_changes.count;
+    save_occupied_snapshot();
+    
+    if (save_state.db_changes.count > 0) {
+        begin_database_batch();
+        for (int i = 0; i < save_state.db_changes.count; i++) {
+            Room* current = save_state.db_changes.rooms[i];
+            if (current->is_checked_out) {
+                // 从数据库中删除
+                delete_from_database(current->room_number);
+            } else {
+                // 更新数据库
+                update_database(current);
+            }
+        }
+        commit_database_batch();
+        changeset_clear(&save_state.db_changes);
+    }
+    
+    return save_state.file_changes.count == 0 ? saved : -1;
+}
+
+// 显示主菜单
+void show_main_menu() {
+    printf("\n=== 主菜单 ===\n");
+    printf("1. 客人登记\n");
+    printf("2. 客人结账\n");
+    printf("3. 信息查找\n");
+    printf("4. 统计功能\n");
+    printf("5. 排序功能\n");
+    printf("6. 显示所有房间\n");
+    printf("7. 显示空闲房间\n");
+    printf("8. 维修安排\n");
+    printf("9. 团队入住\n");
+    printf("10. 数据导出\n");
+    printf("11. 智能锁验证\n");
+    printf("12. 夜审\n");
+    printf("13. 范围查询\n");
+    printf("14. 入住分析\n");
+    printf("0. 退出系统\n");
+    printf("================\n");
+}
+
+// 显示房间类型菜单
+void show_room_type_menu() {
+    printf("\n=== 房间类型 ===\n");
+    printf("1. 标准单人间\n");
+    printf("2. 标准双人间\n");
+    printf("3. 豪华单人间\n");
+    printf("4. 豪华双人间\n");
+    printf("5. 套房\n");
+    printf("================\n");
+}
+
+// 创建新房间
+Room* create_room(int room_number, RoomType type, float price) {
+    Room* new_room = (Room*)malloc(sizeof(Room));
+    if (new_room == NULL) {
+        printf("内存分配失败\n");
+        return NULL;
+    }
+    
+    new_room->room_number = room_number;
+    new_room->type = type;
+    new_room->status = AVAILABLE;
+    new_room->price_per_night = price;
+    new_room->is_checked_out = 0;
+    new_room->expected_check_out_time = 0;
+    memset(&new_room->lock, 0, sizeof(LockState));
+    new_room->slot = -1;
+    new_room->dirty = 0;
+    new_room->next = NULL;
+    
+    // 清空客人信息
+    new_room->guest_id = 0;
+    new_room->check_in_time = 0;
+    new_room->check_out_time = 0;
+    
+    return new_room;
+}
+
+// 将房间添加到链表
+void add_room_to_list(Room* new_room) {
+    if (head == NULL) {
+        head = new_room;
+    } else {
+        tail->next = new_room;
+    }
+    tail = new_room;
+    index_insert(new_room);
+    
+    // 分配快照槽位
+    if (slot_table.count == slot_table.capacity) {
+        int capacity = slot_table.capacity ? slot_table.capacity * 2 : 1024;
+        Room** rooms = (Room**)realloc(slot_table.rooms, capacity * sizeof(Room*));
+        unsigned char* dirty = (unsigned char*)realloc(slot_table.page_dirty, capacity >> SNAPSHOT_PAGE_SHIFT);
+        if (rooms != NULL) slot_table.rooms = rooms;
+        if (dirty != NULL) slot_table.page_dirty = dirty;
+        if (rooms == NULL || dirty == NULL) {
+            printf("内存分配失败\n");
+            new_room->slot = -1;
+            return;
+        }
+        memset(dirty + (slot_table.capacity >> SNAPSHOT_PAGE_SHIFT), 0,
+               (capacity - slot_table.capacity) >> SNAPSHOT_PAGE_SHIFT);
+        slot_table.capacity = capacity;
+    }
+    ordered_index_add(new_room);
+    
+    new_room->slot = slot_table.count++;
+    slot_table.rooms[new_room->slot] = new_room;
+    slot_table.room_count++;
+    room_touch(new_room);
+}
+
+// 查找房间
+Room* find_room(int room_number) {
+    if (room_index.capacity == 0) return NULL;
+    
+    int mask = room_index.capacity - 1;
+    int i = (unsigned int)room_number * 2654435761u & mask;
+    while (room_index.slots[i] != NULL) {
+        if (room_index.slots[i]->room_number == room_number) {
+            return room_index.slots[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+// 从链表中删除房间
+void delete_room_from_list(int room_number) {
+    if (head == NULL) return;
+    
+    if (head->room_number == room_number) {
+        Room* temp = head;
+        head = head->next;
+        if (tail == temp) tail = NULL;
+        index_remove(room_number);
+        ordered_index_remove(temp);
+        journal_delete(room_number);
+        if (temp->slot >= 0) {
+            room_touch(temp);
+            slot_table.rooms[temp->slot] = NULL;
+            slot_table.room_count--;
+        }
+        room_forget(temp);
+        free(temp);
+        return;
+    }
+    
+    Room* current = head;
+    while (current->next != NULL && current->next->room_number != room_number) {
+        current = current->next;
+    }
+    
+    if (current->next != NULL) {
+        Room* temp = current->next;
+        current->next = temp->next;
+        if (tail == temp) tail = current;
+        index_remove(room_number);
+        ordered_index_remove(temp);
+        journal_delete(room_number);
+        if (temp->slot >= 0) {
+            room_touch(temp);
+            slot_table.rooms[temp->slot] = NULL;
+            slot_table.room_count--;
+        }
+        room_forget(temp);
+        free(temp);
+    }
+}
+
+// 释放链表内存
+void free_room_list() {
+    Room* current = head;
+    while (current != NULL) {
+        Room* temp = current;
+        current = current->next;
+        free(temp);
+    }
+    head = NULL;
+    tail = NULL;
+    
+    changeset_free(&replication.changes);
+    changeset_free(&save_state.file_changes);
+    changeset_free(&save_state.db_changes);
+    free(save_state.freed_slots);
+    save_state.freed_slots = NULL;
+    save_state.freed_count = 0;
+    save_state.freed_capacity = 0;
+    
+    free(room_index.slots);
+    room_index.slots = NULL;
+    room_index.capacity = 0;
+    room_index.count = 0;
+    
+    skiplist_free(&price_index);
+    skiplist_free(&check_in_index);
+    
+    snapshot_release(slot_table.latest);
+    free(slot_table.rooms);
+    free(slot_table.page_dirty);
+    memset(&slot_table, 0, sizeof(slot_table));
+}
+
+// 将房间放入索引槽位（不检查容量）
+static void index_place(Room** slots, int capacity, Room* room) {
+    int mask = capacity - 1;
+    int i = (unsigned int)room->room_number * 2654435761u & mask;
+    while (slots[i] != NULL && slots[i]->room_number != room->room_number) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = room;
+}
+
+// 将房间加入索引，负载超过一半时扩容
+void index_insert(Room* room) {
+    if ((room_index.count + 1) * 2 > room_index.capacity) {
+        int new_capacity = room_index.capacity ? room_index.capacity * 2 : 64;
+        Room** new_slots = (Room**)calloc(new_capacity, sizeof(Room*));
+        if (new_slots == NULL) {
+            printf("内存分配失败\n");
+            return;
+        }
+        for (int i = 0; i < room_index.capacity; i++) {
+            if (room_index.slots[i] != NULL) {
+                index_place(new_slots, new_capacity, room_index.slots[i]);
+            }
+        }
+        free(room_index.slots);
+        room_index.slots = new_slots;
+        room_index.capacity = new_capacity;
+    }
+    
+    if (find_room(room->room_number) == NULL) {
+        room_index.count++;
+    }
+    index_place(room_index.slots, room_index.capacity, room);
+}
+
+// 从索引中删除房间（后移删除，无需墓碑）
+void index_remove(int room_number) {
+    if (room_index.capacity == 0) return;
+    
+    int mask = room_index.capacity - 1;
+    int i = (unsigned int)room_number * 2654435761u & mask;
+    while (room_index.slots[i] != NULL && room_index.slots[i]->room_number != room_number) {
+        i = (i + 1) & mask;
+    }
+    if (room_index.slots[i] == NULL) return;
+    
+    room_index.slots[i] = NULL;
+    room_index.count--;
+    
+    // 将后续同一探测链上的元素重新放置
+    int j = (i + 1) & mask;
+    while (room_index.slots[j] != NULL) {
+        Room* moved = room_index.slots[j];
+        room_index.slots[j] = NULL;
+        index_place(room_index.slots, room_index.capacity, moved);
+        j = (j + 1) & mask;
+    }
+}
+
+// 获取房间类型名称
+char* get_room_type_name(RoomType type) {
+    switch (type) {
+        case STANDARD_SINGLE: return "标准单人间";
+        case STANDARD_DOUBLE: return "标准双人间";
+        case DELUXE_SINGLE: return "豪华单人间";
+        case DELUXE_DOUBLE: return "豪华双人间";
+        case SUITE: return "套房";
+        default: return "未知类型";
+    }
+}
+
+// 获取房间状态名称
+char* get_room_status_name(RoomStatus status) {
+    switch (status) {
+        case AVAILABLE: return "空闲";
+        case OCCUPIED: return "已入住";
+        case CLEANING: return "清洁中";
+        case MAINTENANCE: return "维修中";
+        default: return "未知状态";
+    }
+}
+
+// 打印房间信息
+void print_room_info(const Room* room) {
+    printf("\n房间号: %d\n", room->room_number);
+    printf("房间类型: %s\n", get_room_type_name(room->type));
+    printf("房间状态: %s\n", get_room_status_name(room->status));
+    printf("每晚价格: %.2f元\n", room->price_per_night);
+    
+    if (room->status == OCCUPIED) {
+        printf("入住时间: %s", ctime(&room->check_in_time));
+        if (room->expected_check_out_time != 0) {
+            printf("预计退房: %s", ctime(&room->expected_check_out_time));
+        }
+        if (room->lock.code[0] != '\0') {
+            printf("智能锁密码: %s\n", room->lock.code);
+        }
+        print_guest_info(room->guest_id);
+    }
+}
+
+// 打印客人信息
+void print_guest_info(int guest_id) {
+    Guest guest;
+    guest_get(guest_id, &guest);
+    printf("客人姓名: %s\n", guest.name);
+    printf("身份证号: %s\n", guest.id_card);
+    printf("电话号码: %s\n", guest.phone);
+    printf("地址: %s\n", guest.address);
+}
+
+// 客人登记功能
+void register_guest() {
+    printf("\n=== 客人登记 ===\n");
+    
+    // 显示房间类型
+    show_room_type_menu();
+    
+    int type_choice;
+    printf("请选择房间类型: ");
+    scanf("%d", &type_choice);
+    getchar();
+    
+    if (type_choice < 1 || type_choice > 5) {
+        printf("无效的房间类型选择\n");
+        return;
+    }
+    
+    RoomType selected_type = (RoomType)type_choice;
+    
+    // 显示该类型的空闲房间
+    printf("\n该类型的空闲房间:\n");
+    Room* current = head;
+    int found = 0;
+    
+    while (current != NULL) {
+        if (current->type == selected_type && current->status == AVAILABLE) {
+            printf("房间号: %d, 价格: %.2f元/晚\n", 
+                   current->room_number, current->price_per_night);
+            found = 1;
+        }
+        current = current->next;
+    }
+    
+    if (!found) {
+        printf("该类型没有空闲房间\n");
+        return;
+    }
+    
+    // 选择房间
+    int room_number;
+    printf("请输入要入住的房间号: ");
+    scanf("%d", &room_number);
+    getchar();
+    
+    Room* selected_room = find_room(room_number);
+    if (selected_room == NULL) {
+        printf("房间不存在\n");
+        return;
+    }
+    
+    if (selected_room->status != AVAILABLE) {
+        printf("该房间不可用\n");
+        return;
+    }
+    
+    // 输入客人信息
+    Guest guest;
+    printf("请输入客人信息:\n");
+    printf("姓名: ");
+    scanf("%49s", guest.name);
+    getchar();
+    
+    printf("身份证号: ");
+    scanf("%19s", guest.id_card);
+    getchar();
+    
+    printf("电话号码: ");
+    scanf("%14s", guest.phone);
+    getchar();
+    
+    printf("地址: ");
+    scanf("%99s", guest.address);
+    getchar();
+    
+    int nights;
+    printf("入住天数: ");
+    scanf("%d", &nights);
+    getchar();
+    if (nights < 1) nights = 1;
+    
+    // 更新房间状态
+    selected_room->guest_id = guest_upsert(&guest);
+    selected_room->check_in_time = time(NULL);
+    selected_room->expected_check_out_time = compute_expected_check_out(selected_room->check_in_time, nights);
+    set_room_status(selected_room, OCCUPIED);
+    schedule_room_timers(selected_room);
+    lock_assign_code(selected_room);
+    selected_room->is_checked_out = 0;
+    room_touch(selected_room);
+    
+    // 插入数据库
+    insert_to_database(selected_room);
+    
+    printf("登记成功！\n");
+    print_room_info(selected_room);
+}
+
+// 结账功能
+void check_out() {
+    printf("\n=== 客人结账 ===\n");
+    
+    int room_number;
+    printf("请输入要结账的房间号: ");
+    scanf("%d", &room_number);
+    getchar();
+    
+    Room* room = find_room(room_number);
+    if (room == NULL) {
+        printf("房间不存在\n");
+        return;
+    }
+    
+    if (room->status != OCCUPIED) {
+        printf("该房间没有客人入住\n");
+        return;
+    }
+    
+    // 显示房间信息供确认
+    printf("房间信息确认:\n");
+    print_room_info(room);
+    
+    char confirm;
+    printf("确认结账？(y/n): ");
+    scanf("%c", &confirm);
+    getchar();
+    
+    if (confirm == 'y' || confirm == 'Y') {
+        room->check_out_time = time(NULL);
+        room->expected_check_out_time = 0;
+        lock_clear_code(room);
+        set_room_status(room, CLEANING);
+        schedule_room_timers(room);
+        room->is_checked_out = 1;
+        room_touch(room);
+        
+        // 写入退房归档
+        archive_stay(room);
+        
+        // 更新数据库
+        update_database(room);
+        
+        // 计算账单并入账
+        PostingRecord bill;
+        memset(&bill, 0, sizeof(bill));
+        struct tm tm_out = *localtime(&room->check_out_time);
+        bill.business_date = (tm_out.tm_year + 1900) * 10000 + (tm_out.tm_mon + 1) * 100 + tm_out.tm_mday;
+        bill.room_number = room->room_number;
+        bill.guest_id = room->guest_id;
+        bill.kind = POSTING_SETTLEMENT;
+        bill.amount = compute_stay_charge(price_to_money(room->price_per_night),
+                                          room->check_in_time, room->check_out_time);
+        bill.posted_at = room->check_out_time;
+        append_postings(&bill, 1);
+        
+        char amount[32];
+        format_money(bill.amount, amount, sizeof(amount));
+        printf("应付房费: %s元\n", amount);
+        printf("结账成功！房间已标记为清洁中\n");
+    } else {
+        printf("结账已取消\n");
+    }
+}
+
+// 信息查找功能
+void search_info() {
+    printf("\n=== 信息查找 ===\n");
+    printf("1. 按房间号查找\n");
+    printf("2. 按客人姓名查找\n");
+    printf("3. 按身份证号查找\n");
+    
+    int choice;
+    printf("请选择查找方式: ");
+    scanf("%d", &choice);
+    getchar();
+    
+    switch (choice) {
+        case 1: {
+            int room_number;
+            printf("请输入房间号: ");
+            scanf("%d", &room_number);
+            getchar();
+            
+            Room* room = find_room(room_number);
+            if (room != NULL) {
+                print_room_info(room);
+            } else {
+                printf("未找到该房间\n");
+            }
+            break;
+        }
+        case 2: {
+            char name[50];
+            printf("请输入客人姓名: ");
+            scanf("%49s", name);
+            getchar();
+            
+            Room* current = head;
+            int found = 0;
+            while (current != NULL) {
+                if (current->guest_id != 0 && strcmp(guest_name(current->guest_id), name) == 0) {
+                    print_room_info(current);
+                    found = 1;
+                }
+                current = current->next;
+            }
+            
+            if (!found) {
+                printf("未找到该客人\n");
+            }
+            break;
+        }
+        case 3: {
+            char id_card[20];
+            printf("请输入身份证号: ");
+            scanf("%19s", id_card);
+            getchar();
+            
+            int guest_id = guest_find(id_card);
+            if (guest_id == 0) {
+                printf("未找到该身份证号\n");
+                break;
+            }
+            
+            Room* current = head;
+            while (current != NULL) {
+                if (current->guest_id == guest_id && current->status == OCCUPIED) {
+                    print_room_info(current);
+                }
+                current = current->next;
+            }
+            
+            print_guest_history(guest_id);
+            break;
+        }
+        default:
+            printf("无效选择\n");
+    }
+}
+
+// 统计功能（基于快照，不阻塞入住和退房）
+void statistics() {
+    printf("\n=== 统计信息 ===\n");
+    
+    int total_rooms = 0;
+    int occupied_rooms = 0;
+    int available_rooms = 0;
+    int cleaning_rooms = 0;
+    int maintenance_rooms = 0;
+    Money total_revenue = 0;
+    
+    RoomSnapshot* snapshot = snapshot_acquire();
+    if (snapshot == NULL) return;
+    
+    time_t now = snapshot->taken_at;
+    for (int slot = 0; slot < snapshot->slot_count; slot++) {
+        const Room* current = snapshot_room(snapshot, slot);
+        if (current == NULL) continue;
+        
+        total_rooms++;
+        
+        switch (current->status) {
+            case OCCUPIED:
+                occupied_rooms++;
+                break;
+            case AVAILABLE:
+                available_rooms++;
+                break;
+            case CLEANING:
+                cleaning_rooms++;
+                break;
+            case MAINTENANCE:
+                maintenance_rooms++;
+                break;
+        }
+        
+        if (current->status == OCCUPIED) {
+            total_revenue += compute_stay_charge(price_to_money(current->price_per_night),
+                                                 current->check_in_time, now);
+        }
+    }
+    
+    snapshot_release(snapshot);
+    
+    printf("总房间数: %d\n", total_rooms);
+    printf("已入住房间: %d\n", occupied_rooms);
+    printf("空闲房间: %d\n", available_rooms);
+    printf("清洁中房间: %d\n", cleaning_rooms);
+    printf("维修中房间: %d\n", maintenance_rooms);
+    char revenue[32];
+    format_money(total_revenue, revenue, sizeof(revenue));
+    printf("当前收入: %s元\n", revenue);
+    
+    if (total_rooms > 0) {
+        printf("入住率: %.2f%%\n", (float)occupied_rooms / total_rooms * 100);
+    }
+}
+
+static int sort_choice = 1;
+
+// 按sort_choice比较两个房间，键相同时按房间号
+static int compare_rooms(const void* a, const void* b) {
+    const Room* x = *(const Room* const*)a;
+    const Room* y = *(const Room* const*)b;
+    
+    switch (sort_choice) {
+        case 2:
+            if (x->price_per_night != y->price_per_night) {
+                return x->price_per_night < y->price_per_night ? -1 : 1;
+            }
+            break;
+        case 3:
+            if (x->check_in_time != y->check_in_time) {
+                return x->check_in_time < y->check_in_time ? -1 : 1;
+            }
+            break;
+    }
+    return (x->room_number > y->room_number) - (x->room_number < y->room_number);
+}
+
+// 排序功能：对快照排序后显示，不修改房间链表
+void sort_rooms() {
+    printf("\n=== 排序功能 ===\n");
+    printf("1. 按房间号排序\n");
+    printf("2. 按价格排序\n");
+    printf("3. 按入住时间排序\n");
+    
+    int choice;
+    printf("请选择排序方式: ");
+    scanf("%d", &choice);
+    getchar();
+    
+    if (choice < 1 || choice > 3) {
+        printf("无效选择\n");
+        return;
+    }
+    
+    RoomSnapshot* snapshot = snapshot_acquire();
+    if (snapshot == NULL) return;
+    
+    if (snapshot->room_count < 2) {
+        printf("房间数量不足，无需排序\n");
+        snapshot_release(snapshot);
+        return;
+    }
+    
+    const Room** rooms = (const Room**)malloc(snapshot->room_count * sizeof(Room*));
+    if (rooms == NULL) {
+        printf("内存分配失败\n");
+        snapshot_release(snapshot);
+        return;
+    }
+    
+    int n = 0;
+    for (int slot = 0; slot < snapshot->slot_count; slot++) {
+        const Room* room = snapshot_room(snapshot, slot);
+        if (room != NULL) rooms[n++] = room;
+    }
+    
+    sort_choice = choice;
+    qsort(rooms, n, sizeof(Room*), compare_rooms);
+    
+    printf("排序完成！\n");
+    printf("\n=== 所有房间信息 ===\n");
+    for (int i = 0; i < n; i++) {
+        print_room_info(rooms[i]);
+    }
+    
+    free(rooms);
+    snapshot_release(snapshot);
+}
+
+// 显示所有房间
+void display_all_rooms() {
+    printf("\n=== 所有房间信息 ===\n");
+    
+    RoomSnapshot* snapshot = snapshot_acquire();
+    if (snapshot == NULL) return;
+    
+    if (snapshot->room_count == 0) {
+        printf("暂无房间信息\n");
+    }
+    
+    for (int slot = 0; slot < snapshot->slot_count; slot++) {
+        const Room* room = snapshot_room(snapshot, slot);
+        if (room != NULL) print_room_info(room);
+    }
+    
+    snapshot_release(snapshot);
+}
+
+// 显示空闲房间
+void display_available_rooms() {
+    printf("\n=== 空闲房间信息 ===\n");
+    
+    Room* current = head;
+    int found = 0;
+    
+    while (current != NULL) {
+        if (current->status == AVAILABLE) {
+            printf("房间号: %d, 类型: %s, 价格: %.2f元/晚\n", 
+                   current->room_number, 
+                   get_room_type_name(current->type), 
+                   current->price_per_night);
+            found = 1;
+        }
+        current = current->next;
+    }
+    
+    if (!found) {
+        printf("暂无空闲房间\n");
+    }
+}
+
+// 插入数据到数据库
+void insert_to_database(const Room* room) {
+    storage->insert(room);
+}
+
+// 从数据库删除数据
+void delete_from_database(int room_number) {
+    storage->remove(room_number);
+}
+
+// 更新数据库
+void update_database(const Room* room) {
+    storage->update(room);
+}
+
+// 开始批量写入，提交前的写入作为一个整体
+void begin_database_batch() {
+    storage->begin();
+}
+
+// 提交批量写入
+void commit_database_batch() {
+    storage->commit();
+}
+
+// MySQL后端：插入房间记录
+static void mysql_storage_insert(const Room* room) {
+    if (mysql_conn == NULL) return;
+    
+    Guest guest;
+    guest_get(room->guest_id, &guest);
+    
+    char query[1024];
+    sprintf(query, 
+        "INSERT INTO rooms (room_number, room_type, status, price_per_night, "
+        "guest_name, id_card, phone, address, check_in_time) "
+        "VALUES (%d, %d, %d, %.2f, '%s', '%s', '%s', '%s', %ld)",
+        room->room_number, room->type, room->status, room->price_per_night,
+        guest.name, guest.id_card, guest.phone, 
+        guest.address, room->check_in_time);
+    
+    if (mysql_query(mysql_conn, query) != 0) {
+        printf("数据库插入失败: %s\n", mysql_error(mysql_conn));
+    }
+}
+
+// MySQL后端：删除房间记录
+static void mysql_storage_remove(int room_number) {
+    if (mysql_conn == NULL) return;
+    
+    char query[256];
+    sprintf(query, "DELETE FROM rooms WHERE room_number = %d", room_number);
+    
+    if (mysql_query(mysql_conn, query) != 0) {
+        printf("数据库删除失败: %s\n", mysql_error(mysql_conn));
+    }
+}
+
+// MySQL后端：更新房间记录
+static void mysql_storage_update(const Room* room) {
+    if (mysql_conn == NULL) return;
+    
+    char query[1024];
+    sprintf(query, 
+        "UPDATE rooms SET status = %d, check_out_time = %ld, is_checked_out = %d "
+        "WHERE room_number = %d",
+        room->status, room->check_out_time, room->is_checked_out, room->room_number);
+    
+    if (mysql_query(mysql_conn, query) != 0) {
+        printf("数据库更新失败: %s\n", mysql_error(mysql_conn));
+    }
+} 
+
+// 创建并映射共享内存状态表，发布当前所有房间
+void shm_init() {
+    int fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        perror("共享内存创建失败");
+        return;
+    }
+    
+    if (ftruncate(fd, sizeof(ShmSegment)) != 0) {
+        perror("共享内存大小设置失败");
+        close(fd);
+        return;
+    }
+    
+    void* addr = mmap(NULL, sizeof(ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        perror("共享内存映射失败");
+        return;
+    }
+    
+    shm_segment = (ShmSegment*)addr;
+    
+    // 先使魔数失效，读者在初始化完成前不会使用旧内容
+    __atomic_store_n(&shm_segment->header.magic, 0, __ATOMIC_RELEASE);
+    memset(shm_segment->rooms, 0, sizeof(shm_segment->rooms));
+    memset(shm_segment->events, 0, sizeof(shm_segment->events));
+    shm_segment->header.version = SHM_VERSION;
+    shm_segment->header.room_slots = SHM_ROOM_SLOTS;
+    shm_segment->header.event_slots = SHM_EVENT_SLOTS;
+    shm_segment->header.engine_pid = (int32_t)getpid();
+    shm_segment->header.room_count = 0;
+    shm_segment->header.event_head = 0;
+    
+    Room* current = head;
+    while (current != NULL) {
+        shm_publish_room(current);
+        current = current->next;
+    }
+    
+    __atomic_store_n(&shm_segment->header.magic, SHM_MAGIC, __ATOMIC_RELEASE);
+    printf("共享内存状态表已发布: %s (%u 个房间)\n", SHM_NAME, shm_segment->header.room_count);
+}
+
+// 解除映射并删除共享内存状态表
+void shm_close() {
+    if (shm_segment == NULL) return;
+    
+    __atomic_store_n(&shm_segment->header.magic, 0, __ATOMIC_RELEASE);
+    munmap(shm_segment, sizeof(ShmSegment));
+    shm_segment = NULL;
+    shm_unlink(SHM_NAME);
+}
+
+// 将房间当前状态写入共享内存槽位（序列锁保护）
+void shm_publish_room(Room* room) {
+    if (shm_segment == NULL) return;
+    
+    uint32_t mask = SHM_ROOM_SLOTS - 1;
+    uint32_t i = (uint32_t)room->room_number * 2654435761u & mask;
+    uint32_t probes = 0;
+    while (shm_segment->rooms[i].room_number != 0 &&
+           shm_segment->rooms[i].room_number != room->room_number) {
+        i = (i + 1) & mask;
+        if (++probes == SHM_ROOM_SLOTS) {
+            printf("共享内存房间槽位已满，房间 %d 未发布\n", room->room_number);
+            return;
+        }
+    }
+    
+    ShmRoomSlot* slot = &shm_segment->rooms[i];
+    if (slot->room_number == 0) {
+        shm_segment->header.room_count++;
+    }
+    
+    uint32_t seq = slot->seq;
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    slot->type = room->type;
+    slot->status = room->status;
+    slot->price_per_night = room->price_per_night;
+    slot->check_in_time = room->check_in_time;
+    __atomic_store_n(&slot->room_number, room->room_number, __ATOMIC_RELAXED);
+    
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// 向环形缓冲区追加一条状态变更事件
+void shm_publish_event(int room_number, RoomStatus old_status, RoomStatus new_status) {
+    if (shm_segment == NULL) return;
+    
+    uint64_t n = shm_segment->header.event_head + 1;
+    ShmStatusEvent* event = &shm_segment->events[(n - 1) & (SHM_EVENT_SLOTS - 1)];
+    
+    __atomic_store_n(&event->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    event->room_number = room_number;
+    event->old_status = old_status;
+    event->new_status = new_status;
+    event->timestamp = (int64_t)time(NULL);
+    
+    __atomic_store_n(&event->seq, n, __ATOMIC_RELEASE);
+    __atomic_store_n(&shm_segment->header.event_head, n, __ATOMIC_RELEASE);
+}
+
+// 修改房间状态并发布到共享内存
+void set_room_status(Room* room, RoomStatus status) {
+    RoomStatus old_status = room->status;
+    if (old_status == OCCUPIED && status != OCCUPIED) {
+        skiplist_remove(&check_in_index, room->check_in_time, room);
+    } else if (old_status != OCCUPIED && status == OCCUPIED) {
+        skiplist_insert(&check_in_index, room->check_in_time, room);
+    }
+    room->status = status;
+    room_touch(room);
+    
+    shm_publish_room(room);
+    if (old_status != status) {
+        shm_publish_event(room->room_number, old_status, status);
+    }
+}
+
+// 初始化时间轮
+void timer_init() {
+    memset(&timer_wheel, 0, sizeof(timer_wheel));
+    timer_wheel.current = time(NULL);
+}
+
+// 释放所有未触发的定时任务
+void timer_free_all() {
+    for (int level = 0; level < TW_LEVELS; level++) {
+        for (int i = 0; i < TW_SLOTS; i++) {
+            Timer* current = timer_wheel.slots[level][i];
+            while (current != NULL) {
+                Timer* temp = current;
+                current = current->next;
+                free(temp);
+            }
+            timer_wheel.slots[level][i] = NULL;
+        }
+    }
+    timer_wheel.pending = 0;
+}
+
+// 按到期时间把定时任务挂到对应层的槽位
+static void timer_link(Timer* timer) {
+    time_t expires = timer->expires;
+    time_t delta = expires - timer_wheel.current;
+    int level;
+    
+    if (delta < 0) {
+        expires = timer_wheel.current; // 已过期的任务在下一秒触发
+        delta = 0;
+    }
+    
+    for (level = 0; level < TW_LEVELS - 1; level++) {
+        if (delta < ((time_t)1 << (TW_BITS * (level + 1)))) break;
+    }
+    if (delta >= ((time_t)1 << (TW_BITS * TW_LEVELS))) {
+        expires = timer_wheel.current + ((time_t)1 << (TW_BITS * TW_LEVELS)) - 1;
+    }
+    
+    int idx = (int)((expires >> (TW_BITS * level)) & TW_MASK);
+    Timer** slot = &timer_wheel.slots[level][idx];
+    timer->prev = NULL;
+    timer->next = *slot;
+    if (*slot != NULL) (*slot)->prev = timer;
+    *slot = timer;
+}
+
+// 安排定时任务，O(1)
+void timer_schedule(TimerKind kind, int room_number, time_t expires, time_t stamp, int duration) {
+    Timer* timer = (Timer*)malloc(sizeof(Timer));
+    if (timer == NULL) {
+        printf("内存分配失败\n");
+        return;
+    }
+    
+    timer->expires = expires;
+    timer->kind = kind;
+    timer->room_number = room_number;
+    timer->stamp = stamp;
+    timer->duration = duration;
+    timer_link(timer);
+    timer_wheel.pending++;
+}
+
+// 将高层槽位中的任务重新分配到低层，返回该槽位下标
+static int timer_cascade(int level) {
+    int idx = (int)((timer_wheel.current >> (TW_BITS * level)) & TW_MASK);
+    Timer* current = timer_wheel.slots[level][idx];
+    timer_wheel.slots[level][idx] = NULL;
+    
+    while (current != NULL) {
+        Timer* next = current->next;
+        timer_link(current);
+        current = next;
+    }
+    return idx;
+}
+
+// 推进时间轮到now，触发所有到期任务
+void timer_advance(time_t now) {
+    if (timer_wheel.pending == 0) {
+        if (now >= timer_wheel.current) timer_wheel.current = now + 1;
+        return;
+    }
+    
+    while (timer_wheel.current <= now) {
+        int idx = (int)(timer_wheel.current & TW_MASK);
+        
+        if (idx == 0) {
+            for (int level = 1; level < TW_LEVELS; level++) {
+                if (timer_cascade(level) != 0) break;
+            }
+        }
+        
+        Timer* current = timer_wheel.slots[0][idx];
+        timer_wheel.slots[0][idx] = NULL;
+        timer_wheel.current++;
+        
+        while (current != NULL) {
+            Timer* next = current->next;
+            timer_wheel.pending--;
+            timer_fire(current);
+            free(current);
+            current = next;
+        }
+    }
+}
+
+// 执行到期任务；房间状态已变化的过期任务直接丢弃
+void timer_fire(Timer* timer) {
+    if (timer->kind == TIMER_AUTOSAVE) {
+        save_changed_rooms();
+        timer_schedule(TIMER_AUTOSAVE, 0, timer->expires + AUTOSAVE_INTERVAL, 0, 0);
+        return;
+    }
+    
+    Room* room = find_room(timer->room_number);
+    if (room == NULL) return;
+    
+    switch (timer->kind) {
+        case TIMER_CLEANING_DONE:
+            if (room->status == CLEANING && room->check_out_time == timer->stamp) {
+                set_room_status(room, AVAILABLE);
+                update_database(room);
+                printf("[定时] 房间 %d 清洁完成，已恢复空闲\n", room->room_number);
+            }
+            break;
+        case TIMER_MAINTENANCE_START:
+            if (room->status == OCCUPIED) {
+                printf("[定时] 房间 %d 有客入住，维修顺延1小时\n", room->room_number);
+                timer_schedule(TIMER_MAINTENANCE_START, room->room_number,
+                               timer->expires + MAINTENANCE_RETRY, 0, timer->duration);
+            } else {
+                set_room_status(room, MAINTENANCE);
+                update_database(room);
+                timer_schedule(TIMER_MAINTENANCE_END, room->room_number,
+                               timer->expires + timer->duration, 0, 0);
+                printf("[定时] 房间 %d 开始维修\n", room->room_number);
+            }
+            break;
+        case TIMER_MAINTENANCE_END:
+            if (room->status == MAINTENANCE) {
+                set_room_status(room, AVAILABLE);
+                update_database(room);
+                printf("[定时] 房间 %d 维修结束，已恢复空闲\n", room->room_number);
+            }
+            break;
+        case TIMER_OVERSTAY:
+            if (room->status == OCCUPIED && room->expected_check_out_time == timer->stamp) {
+                printf("[提醒] 房间 %d 客人 %s 已超过预计退房时间 %s",
+                       room->room_number, guest_name(room->guest_id), ctime(&room->expected_check_out_time));
+            }
+            break;
+        case TIMER_AUTOSAVE:
+            break; // 已在上面处理
+    }
+}
+
+// 根据房间当前状态安排清洁完成或超时提醒任务
+void schedule_room_timers(Room* room) {
+    if (room->status == CLEANING) {
+        timer_schedule(TIMER_CLEANING_DONE, room->room_number,
+                       room->check_out_time + CLEANING_DURATION, room->check_out_time, 0);
+    } else if (room->status == OCCUPIED && room->expected_check_out_time != 0) {
+        timer_schedule(TIMER_OVERSTAY, room->room_number,
+                       room->expected_check_out_time, room->expected_check_out_time, 0);
+    }
+}
+
+// 计算预计退房时间：入住日起第nights天的规定退房时刻
+time_t compute_expected_check_out(time_t check_in_time, int nights) {
+    struct tm tm_out = *localtime(&check_in_time);
+    tm_out.tm_mday += nights;
+    tm_out.tm_hour = CHECK_OUT_HOUR;
+    tm_out.tm_min = 0;
+    tm_out.tm_sec = 0;
+    tm_out.tm_isdst = -1;
+    return mktime(&tm_out);
+}
+
+// 维修安排功能
+void schedule_maintenance() {
+    printf("\n=== 维修安排 ===\n");
+    
+    int room_number;
+    printf("请输入房间号: ");
+    scanf("%d", &room_number);
+    getchar();
+    
+    if (find_room(room_number) == NULL) {
+        printf("房间不存在\n");
+        return;
+    }
+    
+    int start_hours, duration_hours;
+    printf("几小时后开始: ");
+    scanf("%d", &start_hours);
+    getchar();
+    
+    printf("维修时长(小时): ");
+    scanf("%d", &duration_hours);
+    getchar();
+    
+    if (start_hours < 0 || duration_hours <= 0) {
+        printf("无效的时间\n");
+        return;
+    }
+    
+    timer_schedule(TIMER_MAINTENANCE_START, room_number,
+                   time(NULL) + (time_t)start_hours * 3600, 0, duration_hours * 3600);
+    printf("维修已安排\n");
+}
+
+// 按房间号升序比较
+static int compare_room_number(const void* a, const void* b) {
+    int x = (*(Room* const*)a)->room_number;
+    int y = (*(Room* const*)b)->room_number;
+    return (x > y) - (x < y);
+}
+
+// 同一楼层的一段候选房间
+typedef struct FloorRun {
+    int start;              // 在候选数组中的起始下标
+    int length;             // 房间数
+} FloorRun;
+
+// 按楼层剩余房间数降序比较
+static int compare_floor_run(const void* a, const void* b) {
+    const FloorRun* x = (const FloorRun*)a;
+    const FloorRun* y = (const FloorRun*)b;
+    if (x->length != y->length) return y->length - x->length;
+    return x->start - y->start;
+}
+
+// 在[start, start+length)中选k个房间号跨度最小的相邻房间，返回窗口起点
+static int best_window(Room** rooms, int start, int length, int k) {
+    int best = start;
+    int best_span = -1;
+    for (int i = start; i + k <= start + length; i++) {
+        int span = rooms[i + k - 1]->room_number - rooms[i]->room_number;
+        if (best_span < 0 || span < best_span) {
+            best_span = span;
+            best = i;
+        }
+    }
+    return best;
+}
+
+// 从按房间号排好序的候选房间中选k间：优先单层相邻，否则按楼层剩余数从多到少依次取
+static int pick_rooms(Room** rooms, int n, int k, Room** out) {
+    if (k <= 0) return 0;
+    if (n < k) return -1;
+    
+    FloorRun* runs = (FloorRun*)malloc(n * sizeof(FloorRun));
+    if (runs == NULL) return -1;
+    
+    int run_count = 0;
+    for (int i = 0; i < n; i++) {
+        if (i == 0 || ROOM_FLOOR(rooms[i]->room_number) != ROOM_FLOOR(rooms[i - 1]->room_number)) {
+            runs[run_count].start = i;
+            runs[run_count].length = 0;
+            run_count++;
+        }
+        runs[run_count - 1].length++;
+    }
+    
+    // 单层能容纳时选跨度最小的窗口
+    int best_start = -1;
+    int best_span = -1;
+    for (int r = 0; r < run_count; r++) {
+        if (runs[r].length < k) continue;
+        int w = best_window(rooms, runs[r].start, runs[r].length, k);
+        int span = rooms[w + k - 1]->room_number - rooms[w]->room_number;
+        if (best_span < 0 || span < best_span) {
+            best_span = span;
+            best_start = w;
+        }
+    }
+    
+    int picked = 0;
+    if (best_start >= 0) {
+        for (int i = 0; i < k; i++) out[picked++] = rooms[best_start + i];
+    } else {
+        // 跨楼层时尽量少占楼层
+        qsort(runs, run_count, sizeof(FloorRun), compare_floor_run);
+        for (int r = 0; r < run_count && picked < k; r++) {
+            int take = runs[r].length < k - picked ? runs[r].length : k - picked;
+            int w = best_window(rooms, runs[r].start, runs[r].length, take);
+            for (int i = 0; i < take; i++) out[picked++] = rooms[w + i];
+        }
+    }
+    
+    free(runs);
+    return picked;
+}
+
+// 为团队一次性分配房间，counts[i]为类型i+1所需房间数
+// 每种类型优先使用已清洁的空闲房间，不足时再使用清洁中的房间
+// 任一类型房间不足时不分配任何房间并返回-1；成功返回分配的房间数，房间写入assigned
+int assign_group_rooms(const int counts[ROOM_TYPE_COUNT], Room** assigned) {
+    Room** available[ROOM_TYPE_COUNT] = {NULL};
+    Room** cleaning[ROOM_TYPE_COUNT] = {NULL};
+    int available_count[ROOM_TYPE_COUNT] = {0};
+    int cleaning_count[ROOM_TYPE_COUNT] = {0};
+    int total = 0;
+    int result = -1;
+    
+    // 一次遍历按类型收集候选房间
+    int room_total = 0;
+    for (Room* current = head; current != NULL; current = current->next) room_total++;
+    for (int t = 0; t < ROOM_TYPE_COUNT; t++) {
+        available[t] = (Room**)malloc((room_total + 1) * sizeof(Room*));
+        cleaning[t] = (Room**)malloc((room_total + 1) * sizeof(Room*));
+        if (available[t] == NULL || cleaning[t] == NULL) {
+            printf("内存分配失败\n");
+            goto done;
+        }
+    }
+    for (Room* current = head; current != NULL; current = current->next) {
+        int t = current->type - 1;
+        if (t < 0 || t >= ROOM_TYPE_COUNT) continue;
+        if (current->status == AVAILABLE) {
+            available[t][available_count[t]++] = current;
+        } else if (current->status == CLEANING) {
+            cleaning[t][cleaning_count[t]++] = current;
+        }
+    }
+    
+    // 先检查所有类型是否都够用，保证要么全部分配要么都不分配
+    for (int t = 0; t < ROOM_TYPE_COUNT; t++) {
+        if (counts[t] < 0 || counts[t] > available_count[t] + cleaning_count[t]) {
+            printf("%s 房间不足：需要 %d 间，可用 %d 间\n", get_room_type_name((RoomType)(t + 1)),
+                   counts[t], available_count[t] + cleaning_count[t]);
+            goto done;
+        }
+    }
+    
+    for (int t = 0; t < ROOM_TYPE_COUNT; t++) {
+        int need = counts[t];
+        if (need == 0) continue;
+        
+        qsort(available[t], available_count[t], sizeof(Room*), compare_room_number);
+        int from_available = need < available_count[t] ? need : available_count[t];
+        total += pick_rooms(available[t], available_count[t], from_available, assigned + total);
+        
+        if (need > from_available) {
+            qsort(cleaning[t], cleaning_count[t], sizeof(Room*), compare_room_number);
+            total += pick_rooms(cleaning[t], cleaning_count[t], need - from_available, assigned + total);
+        }
+    }
+    result = total;
+    
+done:
+    for (int t = 0; t < ROOM_TYPE_COUNT; t++) {
+        free(available[t]);
+        free(cleaning[t]);
+    }
+    return result;
+}
+
+// 只写入房间快照文件和客人表（不同步数据库）
+// 每个槽位在文件中占一条记录，已删除的槽位写入空记录
+// 文件布局与槽位一致时只原地更新修改过的房间，否则整体重写
+void save_occupied_snapshot() {
+    Room blank;
+    memset(&blank, 0, sizeof(blank));
+    
+    if (!save_state.layout_valid) {
+        FILE* occupied_file = fopen("occupied_rooms.dat", "wb");
+        if (occupied_file == NULL) {
+            printf("文件操作失败\n");
+            return;
+        }
+        
+        RoomSnapshot* snapshot = snapshot_acquire();
+        int failed = snapshot == NULL;
+        for (int slot = 0; !failed && slot < snapshot->slot_count; slot++) {
+            const Room* current = snapshot_room(snapshot, slot);
+            failed = fwrite(current != NULL ? current : &blank, sizeof(Room), 1, occupied_file) != 1;
+        }
+        snapshot_release(snapshot);
+        if (fclose(occupied_file) != 0 || failed) {
+            printf("文件操作失败\n");
+            return;
+        }
+        save_state.layout_valid = 1;
+    } else if (save_state.file_changes.count > 0 || save_state.freed_count > 0) {
+        int fd = open("occupied_rooms.dat", O_WRONLY | O_CREAT, 0644);
+        if (fd < 0) {
+            printf("文件操作失败\n");
+            return;
+        }
+        
+        int failed = 0;
+        for (int i = 0; i < save_state.freed_count && !failed; i++) {
+            off_t offset = (off_t)save_state.freed_slots[i] * sizeof(Room);
+            failed = pwrite(fd, &blank, sizeof(Room), offset) != (ssize_t)sizeof(Room);
+        }
+        for (int i = 0; i < save_state.file_changes.count && !failed; i++) {
+            Room* current = save_state.file_changes.rooms[i];
+            if (current->slot < 0) continue;
+            
+            Room image = *current;
+            image.next = NULL;
+            image.dirty = 0;
+            failed = pwrite(fd, &image, sizeof(Room), (off_t)current->slot * sizeof(Room)) != (ssize_t)sizeof(Room);
+        }
+        if (close(fd) != 0 || failed) {
+            printf("文件操作失败\n");
+            return;
+        }
+    }
+    
+    changeset_clear(&save_state.file_changes);
+    save_state.freed_count = 0;
+    guest_store_save();
+}
+
+// 团队入住功能
+void group_check_in() {
+    printf("\n=== 团队入住 ===\n");
+    
+    int group_size;
+    printf("团队人数: ");
+    scanf("%d", &group_size);
+    getchar();
+    if (group_size <= 0) {
+        printf("无效的人数\n");
+        return;
+    }
+    
+    // 各类型可住人数：单人间1人，双人间2人，套房3人
+    static const int capacity[ROOM_TYPE_COUNT] = {1, 2, 1, 2, 3};
+    int counts[ROOM_TYPE_COUNT];
+    int room_count = 0;
+    int beds = 0;
+    for (int t = 0; t < ROOM_TYPE_COUNT; t++) {
+        printf("%s 房间数: ", get_room_type_name((RoomType)(t + 1)));
+        scanf("%d", &counts[t]);
+        getchar();
+        if (counts[t] < 0) counts[t] = 0;
+        room_count += counts[t];
+        beds += counts[t] * capacity[t];
+    }
+    
+    if (room_count == 0) {
+        printf("未选择任何房间\n");
+        return;
+    }
+    if (beds < group_size) {
+        printf("所选房间最多可住 %d 人，不足 %d 人\n", beds, group_size);
+        return;
+    }
+    
+    Guest leader;
+    memset(&leader, 0, sizeof(leader));
+    printf("团队名称: ");
+    scanf("%49s", leader.name);
+    getchar();
+    printf("领队身份证号: ");
+    scanf("%19s", leader.id_card);
+    getchar();
+    printf("联系电话: ");
+    scanf("%14s", leader.phone);
+    getchar();
+    printf("地址: ");
+    scanf("%99s", leader.address);
+    getchar();
+    
+    int nights;
+    printf("入住天数: ");
+    scanf("%d", &nights);
+    getchar();
+    if (nights < 1) nights = 1;
+    
+    Room** assigned = (Room**)malloc(room_count * sizeof(Room*));
+    if (assigned == NULL) {
+        printf("内存分配失败\n");
+        return;
+    }
+    
+    int total = assign_group_rooms(counts, assigned);
+    if (total < 0) {
+        printf("团队入住失败，未分配任何房间\n");
+        free(assigned);
+        return;
+    }
+    
+    time_t now = time(NULL);
+    time_t expected = compute_expected_check_out(now, nights);
+    
+    // 整个团队在一个事务内写入数据库
+    begin_database_batch();
+    
+    int leader_id = guest_upsert(&leader);
+    for (int i = 0; i < total; i++) {
+        Room* room = assigned[i];
+        room->guest_id = leader_id;
+        room->check_in_time = now;
+        room->expected_check_out_time = expected;
+        room->is_checked_out = 0;
+        room_touch(room);
+        set_room_status(room, OCCUPIED);
+        schedule_room_timers(room);
+        lock_assign_code(room);
+        insert_to_database(room);
+    }
+    
+    commit_database_batch();
+    
+    save_occupied_snapshot();
+    
+    printf("团队入住成功！共分配 %d 间房:\n", total);
+    for (int i = 0; i < total; i++) {
+        printf("房间号: %d, 类型: %s, 楼层: %d, 智能锁密码: %s\n", assigned[i]->room_number,
+               get_room_type_name(assigned[i]->type), ROOM_FLOOR(assigned[i]->room_number),
+               assigned[i]->lock.code);
+    }
+    
+    free(assigned);
+}
+
+// 确保缓冲区还能写入extra字节
+static int buffer_reserve(ExportBuffer* buf, size_t extra) {
+    if (buf->size + extra <= buf->capacity) return 1;
+    
+    size_t capacity = buf->capacity ? buf->capacity : 4096;
+    while (capacity < buf->size + extra) capacity *= 2;
+    unsigned char* data = (unsigned char*)realloc(buf->data, capacity);
+    if (data == NULL) return 0;
+    buf->data = data;
+    buf->capacity = capacity;
+    return 1;
+}
+
+static void buffer_put_u8(ExportBuffer* buf, unsigned char value) {
+    if (buffer_reserve(buf, 1)) buf->data[buf->size++] = value;
+}
+
+static void buffer_put_varint(ExportBuffer* buf, uint64_t value) {
+    if (!buffer_reserve(buf, 10)) return;
+    while (value >= 0x80) {
+        buf->data[buf->size++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    buf->data[buf->size++] = (unsigned char)value;
+}
+
+static void buffer_put_zigzag(ExportBuffer* buf, int64_t value) {
+    buffer_put_varint(buf, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static void buffer_put_string(ExportBuffer* buf, const char* str, size_t max_len) {
+    size_t len = strnlen(str, max_len);
+    buffer_put_varint(buf, len);
+    if (buffer_reserve(buf, len)) {
+        memcpy(buf->data + buf->size, str, len);
+        buf->size += len;
+    }
+}
+
+static void write_u32(FILE* file, uint32_t value) {
+    unsigned char bytes[4] = {value, value >> 8, value >> 16, value >> 24};
+    fwrite(bytes, 1, 4, file);
+}
+
+// 写入文件头：魔数、版本、字典和列名
+static void export_write_header(FILE* file) {
+    static const char* column_names[EXPORT_COLUMNS] = {
+        "source", "room_number", "type", "status", "price_cents",
+        "check_in_time", "check_out_time", "guest_name", "id_card"
+    };
+    ExportBuffer buf = {NULL, 0, 0};
+    
+    fwrite(EXPORT_MAGIC, 1, 4, file);
+    buffer_put_u8(&buf, EXPORT_VERSION);
+    
+    buffer_put_u8(&buf, ROOM_TYPE_COUNT);
+    for (int t = STANDARD_SINGLE; t <= SUITE; t++) {
+        buffer_put_u8(&buf, (unsigned char)t);
+        buffer_put_string(&buf, get_room_type_name((RoomType)t), 64);
+    }
+    buffer_put_u8(&buf, MAINTENANCE - AVAILABLE + 1);
+    for (int st = AVAILABLE; st <= MAINTENANCE; st++) {
+        buffer_put_u8(&buf, (unsigned char)st);
+        buffer_put_string(&buf, get_room_status_name((RoomStatus)st), 64);
+    }
+    
+    buffer_put_u8(&buf, EXPORT_COLUMNS);
+    for (int c = 0; c < EXPORT_COLUMNS; c++) {
+        buffer_put_string(&buf, column_names[c], 64);
+    }
+    
+    fwrite(buf.data, 1, buf.size, file);
+    free(buf.data);
+}
+
+// 将一组房间记录按列编码后写出
+static void export_write_group(FILE* file, ExportBuffer columns[EXPORT_COLUMNS],
+                               const Room* rows, int n, int source) {
+    for (int c = 0; c < EXPORT_COLUMNS; c++) columns[c].size = 0;
+    
+    int64_t prev_room = 0, prev_in = 0, prev_out = 0;
+    for (int i = 0; i < n; i++) {
+        const Room* room = &rows[i];
+        buffer_put_u8(&columns[COL_SOURCE], (unsigned char)source);
+        buffer_put_zigzag(&columns[COL_ROOM_NUMBER], room->room_number - prev_room);
+        buffer_put_u8(&columns[COL_TYPE], (unsigned char)room->type);
+        buffer_put_u8(&columns[COL_STATUS], (unsigned char)room->status);
+        buffer_put_varint(&columns[COL_PRICE_CENTS], (uint64_t)(room->price_per_night * 100.0f + 0.5f));
+        buffer_put_zigzag(&columns[COL_CHECK_IN_TIME], (int64_t)room->check_in_time - prev_in);
+        buffer_put_zigzag(&columns[COL_CHECK_OUT_TIME], (int64_t)room->check_out_time - prev_out);
+        Guest guest;
+        guest_get(room->guest_id, &guest);
+        buffer_put_string(&columns[COL_GUEST_NAME], guest.name, sizeof(guest.name));
+        buffer_put_string(&columns[COL_ID_CARD], guest.id_card, sizeof(guest.id_card));
+        prev_room = room->room_number;
+        prev_in = room->check_in_time;
+        prev_out = room->check_out_time;
+    }
+    
+    ExportBuffer count = {NULL, 0, 0};
+    buffer_put_varint(&count, n);
+    fwrite(count.data, 1, count.size, file);
+    free(count.data);
+    
+    for (int c = 0; c < EXPORT_COLUMNS; c++) {
+        write_u32(file, (uint32_t)columns[c].size);
+        fwrite(columns[c].data, 1, columns[c].size, file);
+    }
+}
+
+// 写出CSV字符串字段（双引号包围，内部引号加倍）
+static void csv_put_string(FILE* file, const char* str, size_t max_len) {
+    fputc('"', file);
+    for (size_t i = 0; i < max_len && str[i] != '\0'; i++) {
+        if (str[i] == '"') fputc('"', file);
+        fputc(str[i], file);
+    }
+    fputc('"', file);
+}
+
+static void export_write_csv(FILE* file, const Room* rows, int n, int source) {
+    for (int i = 0; i < n; i++) {
+        const Room* room = &rows[i];
+        fprintf(file, "%s,%d,%s,%s,%.2f,%ld,%ld,",
+                source ? "archive" : "live", room->room_number,
+                get_room_type_name(room->type), get_room_status_name(room->status),
+                room->price_per_night, (long)room->check_in_time, (long)room->check_out_time);
+        Guest guest;
+        guest_get(room->guest_id, &guest);
+        csv_put_string(file, guest.name, sizeof(guest.name));
+        fputc(',', file);
+        csv_put_string(file, guest.id_card, sizeof(guest.id_card));
+        fputc('\n', file);
+    }
+}
+
+// 导出当前房间表和退房归档，csv非0时导出CSV，否则导出列式二进制
+// 当前房间表从写时复制快照读取，归档文件按行组流式读取
+// 返回导出的行数，失败返回-1
+int export_rooms(const char* path, int csv) {
+    Room* rows = (Room*)malloc(EXPORT_ROW_GROUP * sizeof(Room));
+    RoomSnapshot* snapshot = snapshot_acquire();
+    if (rows == NULL || snapshot == NULL) {
+        printf("内存分配失败\n");
+        free(rows);
+        snapshot_release(snapshot);
+        return -1;
+    }
+    
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("无法创建导出文件: %s\n", path);
+        free(rows);
+        snapshot_release(snapshot);
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, EXPORT_IO_BUFFER);
+    
+    ExportBuffer columns[EXPORT_COLUMNS];
+    memset(columns, 0, sizeof(columns));
+    uint64_t total = 0;
+    
+    if (csv) {
+        fprintf(file, "source,room_number,type,status,price_per_night,check_in_time,check_out_time,guest_name,id_card\n");
+    } else {
+        export_write_header(file);
+    }
+    
+    // 快照页内房间连续存放，按行组收集后写出
+    int n = 0;
+    for (int slot = 0; slot <= snapshot->slot_count; slot++) {
+        const Room* room = slot < snapshot->slot_count ? snapshot_room(snapshot, slot) : NULL;
+        if (room != NULL) rows[n++] = *room;
+        if (n == EXPORT_ROW_GROUP || (slot == snapshot->slot_count && n > 0)) {
+            if (csv) export_write_csv(file, rows, n, 0);
+            else export_write_group(file, columns, rows, n, 0);
+            total += n;
+            n = 0;
+        }
+    }
+    snapshot_release(snapshot);
+    
+    FILE* archive = fopen("checked_out_rooms.dat", "rb");
+    if (archive != NULL) {
+        StayRecord* stays = (StayRecord*)malloc(EXPORT_ROW_GROUP * sizeof(StayRecord));
+        size_t got;
+        while (stays != NULL && (got = fread(stays, sizeof(StayRecord), EXPORT_ROW_GROUP, archive)) > 0) {
+            // 归档记录按退房时的房间状态导出
+            for (size_t i = 0; i < got; i++) {
+                memset(&rows[i], 0, sizeof(Room));
+                rows[i].room_number = stays[i].room_number;
+                rows[i].type = stays[i].type;
+                rows[i].status = CLEANING;
+                rows[i].price_per_night = stays[i].price_per_night;
+                rows[i].guest_id = stays[i].guest_id;
+                rows[i].check_in_time = stays[i].check_in_time;
+                rows[i].check_out_time = stays[i].check_out_time;
+                rows[i].is_checked_out = 1;
+            }
+            if (csv) export_write_csv(file, rows, (int)got, 1);
+            else export_write_group(file, columns, rows, (int)got, 1);
+            total += got;
+        }
+        free(stays);
+        fclose(archive);
+    }
+    
+    if (!csv) {
+        unsigned char footer[8];
+        write_u32(file, 0);
+        for (int i = 0; i < 8; i++) footer[i] = (unsigned char)(total >> (8 * i));
+        fwrite(footer, 1, 8, file);
+        fwrite(EXPORT_MAGIC, 1, 4, file);
+    }
+    
+    int ok = !ferror(file);
+    if (fclose(file) != 0) ok = 0;
+    for (int c = 0; c < EXPORT_COLUMNS; c++) free(columns[c].data);
+    free(rows);
+    
+    if (!ok) {
+        printf("导出文件写入失败: %s\n", path);
+        return -1;
+    }
+    return (int)total;
+}
+
+// 数据导出功能
+void export_data() {
+    printf("\n=== 数据导出 ===\n");
+    printf("1. 列式二进制格式\n");
+    printf("2. CSV格式\n");
+    
+    int choice;
+    printf("请选择导出格式: ");
+    scanf("%d", &choice);
+    getchar();
+    
+    if (choice != 1 && choice != 2) {
+        printf("无效选择\n");
+        return;
+    }
+    
+    char path[256];
+    printf("请输入导出文件名: ");
+    scanf("%255s", path);
+    getchar();
+    
+    int total = export_rooms(path, choice == 2);
+    if (total >= 0) {
+        printf("导出完成，共 %d 条记录\n", total);
+    }
+}
+
+// 为入住房间生成随机开门密码
+void lock_assign_code(Room* room) {
+    unsigned char random_bytes[LOCK_CODE_LENGTH];
+    FILE* urandom = fopen("/dev/urandom", "rb");
+    if (urandom == NULL || fread(random_bytes, 1, sizeof(random_bytes), urandom) != sizeof(random_bytes)) {
+        for (int i = 0; i < LOCK_CODE_LENGTH; i++) random_bytes[i] = (unsigned char)rand();
+    }
+    if (urandom != NULL) fclose(urandom);
+    
+    for (int i = 0; i < LOCK_CODE_LENGTH; i++) {
+        room->lock.code[i] = (char)('0' + random_bytes[i] % 10);
+    }
+    room->lock.code[LOCK_CODE_LENGTH] = '\0';
+    room->lock.failed_attempts = 0;
+    room->lock.window_start = 0;
+    room_touch(room);
+    
+    lock_audit_push(room->room_number, LOCK_OP_SET, 1);
+}
+
+// 退房时清除开门密码
+void lock_clear_code(Room* room) {
+    memset(&room->lock, 0, sizeof(LockState));
+    room_touch(room);
+    lock_audit_push(room->room_number, LOCK_OP_RESET, 1);
+}
+
+// 恒定时间比较，耗时与密码在哪一位不同无关
+static int lock_code_equal(const char* expected, const char* given) {
+    unsigned char diff = 0;
+    size_t given_len = strnlen(given, LOCK_CODE_LENGTH + 1);
+    
+    for (int i = 0; i < LOCK_CODE_LENGTH; i++) {
+        unsigned char c = i < (int)given_len ? (unsigned char)given[i] : 0;
+        diff |= (unsigned char)expected[i] ^ c;
+    }
+    diff |= (unsigned char)(given_len != LOCK_CODE_LENGTH);
+    return diff == 0;
+}
+
+// 验证开门密码，不访问数据库；审计记录进入队列异步写入
+LockResult verify_lock_code(int room_number, const char* code) {
+    Room* room = find_room(room_number);
+    if (room == NULL) {
+        return LOCK_NO_ROOM;
+    }
+    
+    if (room->status != OCCUPIED || room->lock.code[0] == '\0') {
+        lock_audit_push(room_number, LOCK_OP_VERIFY, 0);
+        return LOCK_NOT_OCCUPIED;
+    }
+    
+    time_t now = time(NULL);
+    room_touch(room);
+    if (now - room->lock.window_start >= LOCK_WINDOW) {
+        room->lock.window_start = now;
+        room->lock.failed_attempts = 0;
+    }
+    if (room->lock.failed_attempts >= LOCK_MAX_FAILURES) {
+        lock_audit_push(room_number, LOCK_OP_VERIFY, 0);
+        return LOCK_RATE_LIMITED;
+    }
+    
+    if (!lock_code_equal(room->lock.code, code)) {
+        room->lock.failed_attempts++;
+        lock_audit_push(room_number, LOCK_OP_VERIFY, 0);
+        return LOCK_WRONG_CODE;
+    }
+    
+    room->lock.failed_attempts = 0;
+    lock_audit_push(room_number, LOCK_OP_VERIFY, 1);
+    return LOCK_OK;
+}
+
+// 审计记录入队；队列满时丢弃并计数，不阻塞开门
+void lock_audit_push(int room_number, LockOperation operation, int success) {
+    pthread_mutex_lock(&lock_audit.mutex);
+    
+    if (!lock_audit.running) {
+        // 审计线程未运行（数据库不可用），不记录
+    } else if (lock_audit.count == LOCK_AUDIT_CAPACITY) {
+        lock_audit.dropped++;
+    } else {
+        int tail = (lock_audit.head + lock_audit.count) % LOCK_AUDIT_CAPACITY;
+        lock_audit.records[tail].room_number = room_number;
+        lock_audit.records[tail].operation = operation;
+        lock_audit.records[tail].success = success;
+        lock_audit.records[tail].timestamp = time(NULL);
+        lock_audit.count++;
+        if (lock_audit.count >= LOCK_AUDIT_BATCH) {
+            pthread_cond_signal(&lock_audit.cond);
+        }
+    }
+    
+    pthread_mutex_unlock(&lock_audit.mutex);
+}
+
+// 将一批审计记录拼成一条多行INSERT写入lock_operations
+static void lock_audit_write(MYSQL* conn, const LockAuditRecord* records, int n) {
+    static const char* operation_names[] = {"设置密码", "验证密码", "重置密码"};
+    static char query[LOCK_AUDIT_BATCH * 160 + 128];
+    
+    int len = snprintf(query, sizeof(query),
+        "INSERT INTO lock_operations (room_id, operation_type, operation_result, created_at) VALUES ");
+    for (int i = 0; i < n; i++) {
+        len += snprintf(query + len, sizeof(query) - len,
+            "%s((SELECT id FROM rooms WHERE room_number = %d), '%s', '%s', FROM_UNIXTIME(%ld))",
+            i ? "," : "", records[i].room_number, operation_names[records[i].operation],
+            records[i].success ? "成功" : "失败", (long)records[i].timestamp);
+    }
+    
+    if (mysql_real_query(conn, query, len) != 0) {
+        printf("智能锁审计写入失败: %s\n", mysql_error(conn));
+    }
+}
+
+// 后台线程：每隔LOCK_AUDIT_INTERVAL秒或积累满一批时写出审计记录
+static void* lock_audit_thread(void* arg) {
+    MYSQL* conn = (MYSQL*)arg;
+    LockAuditRecord batch[LOCK_AUDIT_BATCH];
+    
+    mysql_thread_init();
+    pthread_mutex_lock(&lock_audit.mutex);
+    for (;;) {
+        while (lock_audit.running && lock_audit.count < LOCK_AUDIT_BATCH) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += LOCK_AUDIT_INTERVAL;
+            if (pthread_cond_timedwait(&lock_audit.cond, &lock_audit.mutex, &deadline) != 0) break;
+        }
+        
+        int n = 0;
+        while (n < LOCK_AUDIT_BATCH && lock_audit.count > 0) {
+            batch[n++] = lock_audit.records[lock_audit.head];
+            lock_audit.head = (lock_audit.head + 1) % LOCK_AUDIT_CAPACITY;
+            lock_audit.count--;
+        }
+        int running = lock_audit.running;
+        int remaining = lock_audit.count;
+        pthread_mutex_unlock(&lock_audit.mutex);
+        
+        if (n > 0) lock_audit_write(conn, batch, n);
+        
+        pthread_mutex_lock(&lock_audit.mutex);
+        if (!running && remaining == 0) break;
+    }
+    pthread_mutex_unlock(&lock_audit.mutex);
+    
+    mysql_close(conn);
+    mysql_thread_end();
+    return NULL;
+}
+
+// 启动审计线程；数据库不可用时不记录审计
+void lock_audit_start() {
+    if (mysql_conn == NULL) return;
+    
+    MYSQL* conn = connect_database();
+    if (conn == NULL) return;
+    
+    lock_audit.running = 1;
+    if (pthread_create(&lock_audit.thread, NULL, lock_audit_thread, conn) != 0) {
+        printf("智能锁审计线程启动失败\n");
+        lock_audit.running = 0;
+        mysql_close(conn);
+    }
+}
+
+// 停止审计线程并写出剩余记录
+void lock_audit_stop() {
+    pthread_mutex_lock(&lock_audit.mutex);
+    int running = lock_audit.running;
+    lock_audit.running = 0;
+    pthread_cond_signal(&lock_audit.cond);
+    pthread_mutex_unlock(&lock_audit.mutex);
+    
+    if (running) {
+        pthread_join(lock_audit.thread, NULL);
+    }
+    if (lock_audit.dropped > 0) {
+        printf("智能锁审计队列已满，丢弃 %ld 条记录\n", lock_audit.dropped);
+    }
+}
+
+// 智能锁验证功能
+void smart_lock_verify() {
+    printf("\n=== 智能锁验证 ===\n");
+    
+    int room_number;
+    printf("请输入房间号: ");
+    scanf("%d", &room_number);
+    getchar();
+    
+    char code[16];
+    printf("请输入开门密码: ");
+    scanf("%15s", code);
+    getchar();
+    
+    switch (verify_lock_code(room_number, code)) {
+        case LOCK_OK:
+            printf("密码验证成功，门已打开\n");
+            break;
+        case LOCK_WRONG_CODE:
+            printf("智能锁密码错误\n");
+            break;
+        case LOCK_NOT_OCCUPIED:
+            printf("房间未入住\n");
+            break;
+        case LOCK_NO_ROOM:
+            printf("房间不存在\n");
+            break;
+        case LOCK_RATE_LIMITED:
+            printf("失败次数过多，请稍后再试\n");
+            break;
+    }
+}
+
+// 身份证号哈希（FNV-1a）
+static uint32_t guest_hash(const char* id_card) {
+    uint32_t h = 2166136261u;
+    while (*id_card) {
+        h ^= (unsigned char)*id_card++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 将字符串追加到arena，返回偏移
+static uint32_t guest_arena_put(const char* str) {
+    size_t len = strlen(str) + 1;
+    if (guest_store.arena_size + len > guest_store.arena_capacity) {
+        size_t capacity = guest_store.arena_capacity ? guest_store.arena_capacity * 2 : 4096;
+        while (capacity < guest_store.arena_size + len) capacity *= 2;
+        char* arena = (char*)realloc(guest_store.arena, capacity);
+        if (arena == NULL) {
+            printf("内存分配失败\n");
+            return 0;
+        }
+        guest_store.arena = arena;
+        guest_store.arena_capacity = capacity;
+    }
+    
+    uint32_t offset = (uint32_t)guest_store.arena_size;
+    memcpy(guest_store.arena + offset, str, len);
+    guest_store.arena_size += len;
+    return offset;
+}
+
+static const char* guest_arena_get(uint32_t offset) {
+    if (guest_store.arena == NULL || offset >= guest_store.arena_size) return "";
+    return guest_store.arena + offset;
+}
+
+// 把guest_id放入身份证号索引槽位
+static void guest_index_place(int guest_id) {
+    int mask = guest_store.index_capacity - 1;
+    int i = guest_hash(guest_arena_get(guest_store.guests[guest_id - 1].id_card)) & mask;
+    while (guest_store.id_index[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    guest_store.id_index[i] = guest_id;
+}
+
+// 保证索引能容纳count个客人（负载不超过一半），扩容时重建
+static int guest_index_reserve(int count) {
+    if (count * 2 <= guest_store.index_capacity) return 1;
+    
+    int capacity = guest_store.index_capacity ? guest_store.index_capacity : 256;
+    while (count * 2 > capacity) capacity *= 2;
+    int* index = (int*)calloc(capacity, sizeof(int));
+    if (index == NULL) {
+        printf("内存分配失败\n");
+        return 0;
+    }
+    
+    free(guest_store.id_index);
+    guest_store.id_index = index;
+    guest_store.index_capacity = capacity;
+    for (int id = 1; id <= guest_store.count; id++) {
+        guest_index_place(id);
+    }
+    return 1;
+}
+
+// 按身份证号查找客人，未找到返回0
+int guest_find(const char* id_card) {
+    if (guest_store.index_capacity == 0) return 0;
+    
+    int mask = guest_store.index_capacity - 1;
+    int i = guest_hash(id_card) & mask;
+    while (guest_store.id_index[i] != 0) {
+        int id = guest_store.id_index[i];
+        if (strcmp(guest_arena_get(guest_store.guests[id - 1].id_card), id_card) == 0) {
+            return id;
+        }
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
+
+// 登记客人：身份证号已存在时更新变化的字段，否则新建，返回guest_id
+int guest_upsert(const Guest* guest) {
+    int id = guest_find(guest->id_card);
+    if (id != 0) {
+        GuestRecord* record = &guest_store.guests[id - 1];
+        if (strcmp(guest_arena_get(record->name), guest->name) != 0) {
+            record->name = guest_arena_put(guest->name);
+            guest_store.modified = 1;
+        }
+        if (strcmp(guest_arena_get(record->phone), guest->phone) != 0) {
+            record->phone = guest_arena_put(guest->phone);
+            guest_store.modified = 1;
+        }
+        if (strcmp(guest_arena_get(record->address), guest->address) != 0) {
+            record->address = guest_arena_put(guest->address);
+            guest_store.modified = 1;
+        }
+        return id;
+    }
+    
+    if (!guest_index_reserve(guest_store.count + 1)) return 0;
+    if (guest_store.count == guest_store.capacity) {
+        int capacity = guest_store.capacity ? guest_store.capacity * 2 : 256;
+        GuestRecord* guests = (GuestRecord*)realloc(guest_store.guests, capacity * sizeof(GuestRecord));
+        if (guests == NULL) {
+            printf("内存分配失败\n");
+            return 0;
+        }
+        guest_store.guests = guests;
+        guest_store.capacity = capacity;
+    }
+    
+    GuestRecord* record = &guest_store.guests[guest_store.count];
+    record->name = guest_arena_put(guest->name);
+    record->id_card = guest_arena_put(guest->id_card);
+    record->phone = guest_arena_put(guest->phone);
+    record->address = guest_arena_put(guest->address);
+    record->stay_count = 0;
+    record->last_stay = -1;
+    guest_store.count++;
+    guest_store.modified = 1;
+    
+    guest_index_place(guest_store.count);
+    return guest_store.count;
+}
+
+// 获取客人姓名，无效编号返回空串
+const char* guest_name(int guest_id) {
+    if (guest_id <= 0 || guest_id > guest_store.count) return "";
+    return guest_arena_get(guest_store.guests[guest_id - 1].name);
+}
+
+// 将客人信息复制到定长结构体中
+void guest_get(int guest_id, Guest* out) {
+    memset(out, 0, sizeof(Guest));
+    if (guest_id <= 0 || guest_id > guest_store.count) return;
+    
+    GuestRecord* record = &guest_store.guests[guest_id - 1];
+    snprintf(out->name, sizeof(out->name), "%s", guest_arena_get(record->name));
+    snprintf(out->id_card, sizeof(out->id_card), "%s", guest_arena_get(record->id_card));
+    snprintf(out->phone, sizeof(out->phone), "%s", guest_arena_get(record->phone));
+    snprintf(out->address, sizeof(out->address), "%s", guest_arena_get(record->address));
+}
+
+// 从guests.dat加载客人表
+void guest_store_load() {
+    FILE* file = fopen("guests.dat", "rb");
+    if (file == NULL) return;
+    
+    uint32_t header[3];
+    if (fread(header, sizeof(header), 1, file) != 1 || header[0] != GUEST_FILE_MAGIC) {
+        printf("客人信息文件格式错误\n");
+        fclose(file);
+        return;
+    }
+    
+    int count = (int)header[1];
+    size_t arena_size = header[2];
+    GuestRecord* guests = (GuestRecord*)malloc((count > 0 ? count : 1) * sizeof(GuestRecord));
+    char* arena = (char*)malloc(arena_size > 0 ? arena_size : 1);
+    if (guests == NULL || arena == NULL ||
+        fread(guests, sizeof(GuestRecord), count, file) != (size_t)count ||
+        fread(arena, 1, arena_size, file) != arena_size) {
+        printf("客人信息文件读取失败\n");
+        free(guests);
+        free(arena);
+        fclose(file);
+        return;
+    }
+    fclose(file);
+    
+    guest_store_free();
+    guest_store.guests = guests;
+    guest_store.count = count;
+    guest_store.capacity = count;
+    guest_store.arena = arena;
+    guest_store.arena_size = arena_size;
+    guest_store.arena_capacity = arena_size;
+    guest_index_reserve(count);
+}
+
+// 保存客人表到guests.dat
+void guest_store_save() {
+    if (!guest_store.modified) return;
+    
+    FILE* file = fopen("guests.dat", "wb");
+    if (file == NULL) {
+        printf("文件操作失败\n");
+        return;
+    }
+    
+    uint32_t header[3] = {GUEST_FILE_MAGIC, (uint32_t)guest_store.count, (uint32_t)guest_store.arena_size};
+    fwrite(header, sizeof(header), 1, file);
+    fwrite(guest_store.guests, sizeof(GuestRecord), guest_store.count, file);
+    fwrite(guest_store.arena, 1, guest_store.arena_size, file);
+    fclose(file);
+    guest_store.modified = 0;
+}
+
+// 释放客人表
+void guest_store_free() {
+    free(guest_store.guests);
+    free(guest_store.arena);
+    free(guest_store.id_index);
+    memset(&guest_store, 0, sizeof(guest_store));
+}
+
+// 结账时追加一条退房记录，并挂到该客人的历史链上
+void archive_stay(Room* room) {
+    FILE* file = fopen("checked_out_rooms.dat", "ab");
+    if (file == NULL) {
+        printf("文件操作失败\n");
+        return;
+    }
+    
+    fseek(file, 0, SEEK_END);
+    int32_t index = (int32_t)(ftell(file) / sizeof(StayRecord));
+    
+    StayRecord stay;
+    memset(&stay, 0, sizeof(stay));
+    stay.room_number = room->room_number;
+    stay.type = room->type;
+    stay.price_per_night = room->price_per_night;
+    stay.guest_id = room->guest_id;
+    stay.check_in_time = room->check_in_time;
+    stay.check_out_time = room->check_out_time;
+    stay.prev_stay = -1;
+    
+    GuestRecord* record = NULL;
+    if (room->guest_id > 0 && room->guest_id <= guest_store.count) {
+        record = &guest_store.guests[room->guest_id - 1];
+        stay.prev_stay = record->last_stay;
+    }
+    
+    if (fwrite(&stay, sizeof(StayRecord), 1, file) == 1 && record != NULL) {
+        record->last_stay = index;
+        record->stay_count++;
+        guest_store.modified = 1;
+    }
+    fclose(file);
+}
+
+// 沿客人的历史链直接读取其所有退房记录
+void print_guest_history(int guest_id) {
+    if (guest_id <= 0 || guest_id > guest_store.count) return;
+    
+    GuestRecord* record = &guest_store.guests[guest_id - 1];
+    printf("\n客人 %s 共有 %d 次历史入住\n", guest_arena_get(record->name), record->stay_count);
+    if (record->last_stay < 0) return;
+    
+    FILE* file = fopen("checked_out_rooms.dat", "rb");
+    if (file == NULL) return;
+    
+    int32_t index = record->last_stay;
+    StayRecord stay;
+    while (index >= 0) {
+        if (fseek(file, (long)index * sizeof(StayRecord), SEEK_SET) != 0 ||
+            fread(&stay, sizeof(StayRecord), 1, file) != 1) {
+            break;
+        }
+        printf("房间号: %d, 类型: %s\n", stay.room_number, get_room_type_name(stay.type));
+        printf("  入住时间: %s", ctime(&stay.check_in_time));
+        printf("  退房时间: %s", ctime(&stay.check_out_time));
+        index = stay.prev_stay;
+    }
+    fclose(file);
+}
+
+// 标记房间所在页已修改，下一次快照会复制该页
+void room_touch(Room* room) {
+    if (room->slot >= 0 && room->slot < slot_table.count) {
+        slot_table.page_dirty[room->slot >> SNAPSHOT_PAGE_SHIFT] = 1;
+    }
+    
+    // 记录待保存的房间；有备机连接时记录待发送的房间
+    changeset_add(&save_state.file_changes, room);
+    changeset_add(&save_state.db_changes, room);
+    if (replication.standby_count > 0) {
+        changeset_add(&replication.changes, room);
+    }
+}
+
+static void page_release(RoomPage* page) {
+    if (page != NULL && __atomic_sub_fetch(&page->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(page);
+    }
+}
+
+// 获取当前房间表的只读快照，必须在修改房间表的线程中调用
+// 没有修改时直接复用上一个快照；否则只复制被修改过的页，其余页与上一个快照共享
+RoomSnapshot* snapshot_acquire() {
+    RoomSnapshot* latest = slot_table.latest;
+    int page_count = (slot_table.count + SNAPSHOT_PAGE_SIZE - 1) >> SNAPSHOT_PAGE_SHIFT;
+    
+    int changed = latest == NULL || latest->page_count != page_count;
+    for (int p = 0; !changed && p < page_count; p++) {
+        changed = slot_table.page_dirty[p];
+    }
+    if (!changed) {
+        __atomic_add_fetch(&latest->refcount, 1, __ATOMIC_RELAXED);
+        return latest;
+    }
+    
+    RoomSnapshot* snapshot = (RoomSnapshot*)malloc(sizeof(RoomSnapshot));
+    RoomPage** pages = (RoomPage**)calloc(page_count > 0 ? page_count : 1, sizeof(RoomPage*));
+    if (snapshot == NULL || pages == NULL) {
+        printf("内存分配失败\n");
+        free(snapshot);
+        free(pages);
+        return NULL;
+    }
+    
+    for (int p = 0; p < page_count; p++) {
+        if (latest != NULL && p < latest->page_count && !slot_table.page_dirty[p]) {
+            pages[p] = latest->pages[p];
+            __atomic_add_fetch(&pages[p]->refcount, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        
+        RoomPage* page = (RoomPage*)calloc(1, sizeof(RoomPage));
+        if (page == NULL) {
+            printf("内存分配失败\n");
+            for (int q = 0; q < p; q++) page_release(pages[q]);
+            free(pages);
+            free(snapshot);
+            return NULL;
+        }
+        page->refcount = 1;
+        for (int i = 0; i < SNAPSHOT_PAGE_SIZE; i++) {
+            int slot = (p << SNAPSHOT_PAGE_SHIFT) + i;
+            if (slot < slot_table.count && slot_table.rooms[slot] != NULL) {
+                page->rooms[i] = *slot_table.rooms[slot];
+                page->rooms[i].next = NULL;
+            }
+        }
+        pages[p] = page;
+        slot_table.page_dirty[p] = 0;
+    }
+    
+    snapshot->refcount = 2; // 调用者一个，slot_table.latest一个
+    snapshot->taken_at = time(NULL);
+    snapshot->slot_count = slot_table.count;
+    snapshot->room_count = slot_table.room_count;
+    snapshot->page_count = page_count;
+    snapshot->pages = pages;
+    
+    slot_table.latest = snapshot;
+    snapshot_release(latest);
+    return snapshot;
+}
+
+// 释放快照引用，最后一个引用释放时回收独占的页
+void snapshot_release(RoomSnapshot* snapshot) {
+    if (snapshot == NULL) return;
+    if (__atomic_sub_fetch(&snapshot->refcount, 1, __ATOMIC_ACQ_REL) != 0) return;
+    
+    for (int p = 0; p < snapshot->page_count; p++) {
+        page_release(snapshot->pages[p]);
+    }
+    free(snapshot->pages);
+    free(snapshot);
+}
+
+// 读取快照中的一个槽位，空槽返回NULL
+const Room* snapshot_room(const RoomSnapshot* snapshot, int slot) {
+    if (slot < 0 || slot >= snapshot->slot_count) return NULL;
+    
+    const Room* room = &snapshot->pages[slot >> SNAPSHOT_PAGE_SHIFT]->rooms[slot & (SNAPSHOT_PAGE_SIZE - 1)];
+    return room->room_number != 0 ? room : NULL;
+}
+
+// 每晚价格转为分（四舍五入）
+Money price_to_money(float price) {
+    double cents = (double)price * 100.0;
+    return (Money)(cents >= 0 ? cents + 0.5 : cents - 0.5);
+}
+
+// 格式化金额为"元.角分"
+void format_money(Money amount, char* buf, size_t size) {
+    const char* sign = amount < 0 ? "-" : "";
+    uint64_t abs_amount = amount < 0 ? (uint64_t)(-(amount + 1)) + 1 : (uint64_t)amount;
+    snprintf(buf, size, "%s%llu.%02llu", sign,
+             (unsigned long long)(abs_amount / 100), (unsigned long long)(abs_amount % 100));
+}
+
+// 当地日期的日序号（按中午计算，避免夏令时影响）
+static long local_day_number(time_t t) {
+    struct tm tm_day = *localtime(&t);
+    tm_day.tm_hour = 12;
+    tm_day.tm_min = 0;
+    tm_day.tm_sec = 0;
+    tm_day.tm_isdst = -1;
+    return (long)(mktime(&tm_day) / (24 * 3600));
+}
+
+// 计算一次住宿的房费（分）
+// 每跨过一个日期计一晚，当天离店按一晚计；
+// 最后一天超过规定退房时刻离店时，LATE_CHECK_OUT_HOUR前加收半晚，之后加收一晚
+Money compute_stay_charge(Money rate, time_t check_in_time, time_t check_out_time) {
+    if (check_out_time <= check_in_time) return rate;
+    
+    long nights = local_day_number(check_out_time) - local_day_number(check_in_time);
+    if (nights <= 0) return rate;
+    
+    Money charge = rate * nights;
+    struct tm tm_out = *localtime(&check_out_time);
+    int minutes = tm_out.tm_hour * 60 + tm_out.tm_min;
+    if (minutes >= LATE_CHECK_OUT_HOUR * 60) {
+        charge += rate;
+    } else if (minutes > CHECK_OUT_HOUR * 60) {
+        charge += (rate + 1) / 2;
+    }
+    return charge;
+}
+
+// 追加入账记录到postings.dat
+void append_postings(const PostingRecord* postings, int count) {
+    if (count <= 0) return;
+    
+    FILE* file = fopen("postings.dat", "ab");
+    if (file == NULL) {
+        printf("文件操作失败\n");
+        return;
+    }
+    if (fwrite(postings, sizeof(PostingRecord), count, file) != (size_t)count) {
+        printf("入账记录写入失败\n");
+    }
+    fclose(file);
+}
+
+// 夜审工作线程：为负责页范围内的每个在住房间计提当晚房费
+static void* audit_worker(void* arg) {
+    AuditTask* task = (AuditTask*)arg;
+    
+    for (int p = task->first_page; p < task->last_page; p++) {
+        for (int i = 0; i < SNAPSHOT_PAGE_SIZE; i++) {
+            const Room* room = snapshot_room(task->snapshot, (p << SNAPSHOT_PAGE_SHIFT) + i);
+            if (room == NULL || room->status != OCCUPIED || room->check_in_time > task->posted_at) {
+                continue;
+            }
+            
+            PostingRecord* posting = &task->postings[task->count++];
+            posting->business_date = task->business_date;
+            posting->room_number = room->room_number;
+            posting->guest_id = room->guest_id;
+            posting->kind = POSTING_ROOM_CHARGE;
+            posting->amount = price_to_money(room->price_per_night);
+            posting->posted_at = task->posted_at;
+            task->total += posting->amount;
+        }
+    }
+    return NULL;
+}
+
+// 对now所在营业日执行夜审，房间表按页分给多个线程并行处理
+// 结果按槽位顺序合并，同一快照和日期总是得到相同的入账记录
+// 返回入账记录数，该营业日已审过返回0，失败返回-1
+int run_night_audit(time_t now, Money* total) {
+    struct tm tm_now = *localtime(&now);
+    int32_t business_date = (tm_now.tm_year + 1900) * 10000 + (tm_now.tm_mon + 1) * 100 + tm_now.tm_mday;
+    *total = 0;
+    
+    // 同一营业日只审一次
+    int32_t last_date = 0;
+    FILE* state = fopen("night_audit.dat", "rb");
+    if (state != NULL) {
+        if (fread(&last_date, sizeof(last_date), 1, state) != 1) last_date = 0;
+        fclose(state);
+    }
+    if (last_date >= business_date) return 0;
+    
+    // 入账时间取营业日结束时刻，保证重跑结果一致
+    struct tm tm_end = tm_now;
+    tm_end.tm_hour = 23;
+    tm_end.tm_min = 59;
+    tm_end.tm_sec = 59;
+    tm_end.tm_isdst = -1;
+    time_t posted_at = mktime(&tm_end);
+    
+    RoomSnapshot* snapshot = snapshot_acquire();
+    if (snapshot == NULL) return -1;
+    
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cpus > 0 ? (int)cpus : 1;
+    if (workers > AUDIT_MAX_WORKERS) workers = AUDIT_MAX_WORKERS;
+    if (workers > snapshot->page_count) workers = snapshot->page_count > 0 ? snapshot->page_count : 1;
+    
+    AuditTask tasks[AUDIT_MAX_WORKERS];
+    memset(tasks, 0, sizeof(tasks));
+    pthread_t threads[AUDIT_MAX_WORKERS];
+    int started[AUDIT_MAX_WORKERS] = {0};
+    int pages_per_worker = (snapshot->page_count + workers - 1) / workers;
+    int ok = 1;
+    
+    for (int w = 0; w < workers; w++) {
+        AuditTask* task = &tasks[w];
+        task->snapshot = snapshot;
+        task->first_page = w * pages_per_worker;
+        task->last_page = task->first_page + pages_per_worker;
+        if (task->first_page > snapshot->page_count) task->first_page = snapshot->page_count;
+        if (task->last_page > snapshot->page_count) task->last_page = snapshot->page_count;
+        task->business_date = business_date;
+        task->posted_at = posted_at;
+        
+        int pages = task->last_page - task->first_page;
+        task->postings = (PostingRecord*)malloc((pages > 0 ? pages : 1) * SNAPSHOT_PAGE_SIZE * sizeof(PostingRecord));
+        if (task->postings == NULL) {
+            ok = 0;
+            break;
+        }
+        
+        // 第一个分区在当前线程执行
+        if (w > 0) {
+            if (pthread_create(&threads[w], NULL, audit_worker, task) != 0) {
+                ok = 0;
+                break;
+            }
+            started[w] = 1;
+        }
+    }
+    
+    if (ok) audit_worker(&tasks[0]);
+    
+    int count = 0;
+    for (int w = 0; w < workers; w++) {
+        if (started[w]) pthread_join(threads[w], NULL);
+    }
+    if (ok) {
+        for (int w = 0; w < workers; w++) {
+            append_postings(tasks[w].postings, tasks[w].count);
+            count += tasks[w].count;
+            *total += tasks[w].total;
+        }
+        
+        state = fopen("night_audit.dat", "wb");
+        if (state != NULL) {
+            fwrite(&business_date, sizeof(business_date), 1, state);
+            fclose(state);
+        }
+    } else {
+        printf("夜审线程启动失败\n");
+    }
+    
+    for (int w = 0; w < workers; w++) free(tasks[w].postings);
+    snapshot_release(snapshot);
+    return ok ? count : -1;
+}
+
+// 夜审功能
+void night_audit() {
+    printf("\n=== 夜审 ===\n");
+    
+    Money total;
+    int count = run_night_audit(time(NULL), &total);
+    if (count == 0 && total == 0) {
+        printf("本营业日已完成夜审或没有在住房间\n");
+        return;
+    }
+    if (count < 0) {
+        printf("夜审失败\n");
+        return;
+    }
+    
+    char amount[32];
+    format_money(total, amount, sizeof(amount));
+    printf("夜审完成：计提 %d 间在住房间房费，合计 %s元\n", count, amount);
+}
+
+// 随机层数，每层概率1/4（xorshift）
+static int skiplist_random_level(SkipList* list) {
+    int level = 1;
+    for (;;) {
+        list->seed ^= list->seed << 13;
+        list->seed ^= list->seed >> 17;
+        list->seed ^= list->seed << 5;
+        if ((list->seed & 3) != 0 || level == SKIPLIST_MAX_LEVEL) break;
+        level++;
+    }
+    return level;
+}
+
+static SkipNode* skiplist_new_node(int level, int64_t key, Room* room) {
+    SkipNode* node = (SkipNode*)calloc(1, sizeof(SkipNode) + level * sizeof(SkipNode*));
+    if (node == NULL) {
+        printf("内存分配失败\n");
+        return NULL;
+    }
+    node->key = key;
+    node->room = room;
+    node->level = level;
+    return node;
+}
+
+// 节点是否排在(key, room)之前
+static int skipnode_before(const SkipNode* node, int64_t key, const Room* room) {
+    if (node->key != key) return node->key < key;
+    return node->room->room_number < room->room_number;
+}
+
+// 查找每层最后一个排在(key, room)之前的节点
+static void skiplist_find_update(SkipList* list, int64_t key, const Room* room, SkipNode** update) {
+    SkipNode* x = list->head;
+    for (int i = list->level - 1; i >= 0; i--) {
+        while (x->forward[i] != NULL && skipnode_before(x->forward[i], key, room)) {
+            x = x->forward[i];
+        }
+        update[i] = x;
+    }
+}
+
+void skiplist_insert(SkipList* list, int64_t key, Room* room) {
+    if (list->head == NULL) {
+        list->head = skiplist_new_node(SKIPLIST_MAX_LEVEL, 0, NULL);
+        if (list->head == NULL) return;
+        list->level = 1;
+    }
+    
+    SkipNode* update[SKIPLIST_MAX_LEVEL];
+    skiplist_find_update(list, key, room, update);
+    
+    int level = skiplist_random_level(list);
+    for (int i = list->level; i < level; i++) {
+        update[i] = list->head;
+    }
+    if (level > list->level) list->level = level;
+    
+    SkipNode* node = skiplist_new_node(level, key, room);
+    if (node == NULL) return;
+    for (int i = 0; i < level; i++) {
+        node->forward[i] = update[i]->forward[i];
+        update[i]->forward[i] = node;
+    }
+    
+    node->backward = update[0] == list->head ? NULL : update[0];
+    if (node->forward[0] != NULL) {
+        node->forward[0]->backward = node;
+    } else {
+        list->tail = node;
+    }
+    list->count++;
+}
+
+void skiplist_remove(SkipList* list, int64_t key, Room* room) {
+    if (list->head == NULL) return;
+    
+    SkipNode* update[SKIPLIST_MAX_LEVEL];
+    skiplist_find_update(list, key, room, update);
+    
+    SkipNode* node = update[0]->forward[0];
+    if (node == NULL || node->room != room) return;
+    
+    for (int i = 0; i < node->level; i++) {
+        update[i]->forward[i] = node->forward[i];
+    }
+    if (node->forward[0] != NULL) {
+        node->forward[0]->backward = node->backward;
+    } else {
+        list->tail = node->backward;
+    }
+    while (list->level > 1 && list->head->forward[list->level - 1] == NULL) {
+        list->level--;
+    }
+    
+    free(node);
+    list->count--;
+}
+
+// 第一个键不小于key的节点
+SkipNode* skiplist_lower_bound(SkipList* list, int64_t key) {
+    if (list->head == NULL) return NULL;
+    
+    SkipNode* x = list->head;
+    for (int i = list->level - 1; i >= 0; i--) {
+        while (x->forward[i] != NULL && x->forward[i]->key < key) {
+            x = x->forward[i];
+        }
+    }
+    return x->forward[0];
+}
+
+void skiplist_free(SkipList* list) {
+    SkipNode* current = list->head;
+    while (current != NULL) {
+        SkipNode* next = current->forward[0];
+        free(current);
+        current = next;
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->level = 0;
+    list->count = 0;
+}
+
+// 将房间加入有序索引
+void ordered_index_add(Room* room) {
+    skiplist_insert(&price_index, price_to_money(room->price_per_night), room);
+    if (room->status == OCCUPIED) {
+        skiplist_insert(&check_in_index, room->check_in_time, room);
+    }
+}
+
+// 将房间移出有序索引（须在修改价格、入住时间或状态之前调用）
+void ordered_index_remove(Room* room) {
+    skiplist_remove(&price_index, price_to_money(room->price_per_night), room);
+    if (room->status == OCCUPIED) {
+        skiplist_remove(&check_in_index, room->check_in_time, room);
+    }
+}
+
+// 范围查询功能
+void range_query() {
+    printf("\n=== 范围查询 ===\n");
+    printf("1. 按价格区间查询房间\n");
+    printf("2. 查询今天某时刻之前入住的客人\n");
+    printf("3. 入住最久的前k位客人\n");
+    printf("4. 价格最高的前k间房\n");
+    
+    int choice;
+    printf("请选择查询方式: ");
+    scanf("%d", &choice);
+    getchar();
+    
+    int found = 0;
+    switch (choice) {
+        case 1: {
+            float low, high;
+            printf("最低价格: ");
+            scanf("%f", &low);
+            getchar();
+            printf("最高价格: ");
+            scanf("%f", &high);
+            getchar();
+            
+            Money high_key = price_to_money(high);
+            for (SkipNode* node = skiplist_lower_bound(&price_index, price_to_money(low));
+                 node != NULL && node->key <= high_key; node = node->forward[0]) {
+                printf("房间号: %d, 类型: %s, 状态: %s, 价格: %.2f元/晚\n", node->room->room_number,
+                       get_room_type_name(node->room->type), get_room_status_name(node->room->status),
+                       node->room->price_per_night);
+                found++;
+            }
+            break;
+        }
+        case 2: {
+            int hour, minute;
+            printf("时刻(HH:MM): ");
+            if (scanf("%d:%d", &hour, &minute) != 2) hour = minute = 0;
+            getchar();
+            
+            time_t now = time(NULL);
+            struct tm tm_cut = *localtime(&now);
+            tm_cut.tm_hour = hour;
+            tm_cut.tm_min = minute;
+            tm_cut.tm_sec = 0;
+            tm_cut.tm_isdst = -1;
+            time_t cutoff = mktime(&tm_cut);
+            
+            // 入住时间索引只含在住房间，从头遍历到截止时刻
+            for (SkipNode* node = check_in_index.head ? check_in_index.head->forward[0] : NULL;
+                 node != NULL && node->key < cutoff; node = node->forward[0]) {
+                printf("房间号: %d, 客人: %s, 入住时间: %s", node->room->room_number,
+                       guest_name(node->room->guest_id), ctime(&node->room->check_in_time));
+                found++;
+            }
+            break;
+        }
+        case 3:
+        case 4: {
+            int k;
+            printf("k: ");
+            scanf("%d", &k);
+            getchar();
+            
+            if (choice == 3) {
+                for (SkipNode* node = check_in_index.head ? check_in_index.head->forward[0] : NULL;
+                     node != NULL && found < k; node = node->forward[0]) {
+                    printf("房间号: %d, 客人: %s, 入住时间: %s", node->room->room_number,
+                           guest_name(node->room->guest_id), ctime(&node->room->check_in_time));
+                    found++;
+                }
+            } else {
+                for (SkipNode* node = price_index.tail; node != NULL && found < k; node = node->backward) {
+                    printf("房间号: %d, 类型: %s, 价格: %.2f元/晚\n", node->room->room_number,
+                           get_room_type_name(node->room->type), node->room->price_per_night);
+                    found++;
+                }
+            }
+            break;
+        }
+        default:
+            printf("无效选择\n");
+            return;
+    }
+    
+    if (!found) {
+        printf("没有符合条件的记录\n");
+    }
+}
+
+// 当前时间（微秒）
+int64_t now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 创建监听套接字；已有主机在运行时不启用复制
+void replication_listen() {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", JOURNAL_SOCKET_PATH);
+    
+    // 能连上说明另一个主机正在运行，否则是残留的套接字文件
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0) {
+        int alive = connect(probe, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+        close(probe);
+        if (alive) {
+            printf("已有主机在运行，未启用热备复制\n");
+            return;
+        }
+    }
+    unlink(JOURNAL_SOCKET_PATH);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, JOURNAL_MAX_STANDBYS) != 0) {
+        perror("热备套接字创建失败");
+        if (fd >= 0) close(fd);
+        return;
+    }
+    
+    replication.listen_fd = fd;
+    replication.last_heartbeat_us = now_us();
+}
+
+// 发送一条日志记录，失败时断开该备机
+static void journal_send(int index, const JournalRecord* record) {
+    const char* data = (const char*)record;
+    size_t left = sizeof(JournalRecord);
+    
+    while (left > 0) {
+        ssize_t n = send(replication.standby_fds[index], data, left, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            printf("备机连接已断开\n");
+            close(replication.standby_fds[index]);
+            replication.standby_fds[index] = replication.standby_fds[--replication.standby_count];
+            return;
+        }
+        data += n;
+        left -= n;
+    }
+}
+
+// 发送给所有备机
+static void journal_broadcast(JournalRecord* record) {
+    record->magic = JOURNAL_MAGIC;
+    record->lsn = ++replication.lsn;
+    record->sent_at_us = now_us();
+    for (int i = replication.standby_count - 1; i >= 0; i--) {
+        journal_send(i, record);
+    }
+}
+
+// 填充房间镜像记录
+static void journal_fill_room(JournalRecord* record, const Room* room) {
+    memset(record, 0, sizeof(JournalRecord));
+    record->op = JOURNAL_UPSERT;
+    record->room = *room;
+    record->room.next = NULL;
+    record->room.dirty = 0;
+    guest_get(room->guest_id, &record->guest);
+}
+
+// 接受新的备机连接，并发送当前完整房间表作为基线
+void replication_accept() {
+    int fd = accept(replication.listen_fd, NULL, NULL);
+    if (fd < 0) return;
+    
+    if (replication.standby_count == JOURNAL_MAX_STANDBYS) {
+        printf("备机数已达上限，拒绝连接\n");
+        close(fd);
+        return;
+    }
+    
+    // 先发出已有修改，基线之后只需发送新的修改
+    journal_flush();
+    
+    int index = replication.standby_count++;
+    replication.standby_fds[index] = fd;
+    
+    JournalRecord record;
+    uint64_t baseline = 0;
+    for (Room* current = head; current != NULL && index < replication.standby_count; current = current->next) {
+        journal_fill_room(&record, current);
+        record.magic = JOURNAL_MAGIC;
+        record.lsn = ++replication.lsn;
+        record.sent_at_us = now_us();
+        journal_send(index, &record);
+        baseline++;
+    }
+    if (index < replication.standby_count) {
+        printf("备机已连接，已发送 %llu 个房间的基线\n", (unsigned long long)baseline);
+    }
+}
+
+// 把待发送的房间镜像发给所有备机
+void journal_flush() {
+    if (replication.changes.count == 0) return;
+    
+    JournalRecord record;
+    for (int i = 0; i < replication.changes.count && replication.standby_count > 0; i++) {
+        journal_fill_room(&record, replication.changes.rooms[i]);
+        journal_broadcast(&record);
+    }
+    changeset_clear(&replication.changes);
+}
+
+// 发送删除记录（在房间节点释放前调用）
+void journal_delete(int room_number) {
+    if (replication.standby_count == 0) return;
+    
+    JournalRecord record;
+    memset(&record, 0, sizeof(record));
+    record.op = JOURNAL_DELETE;
+    record.room.room_number = room_number;
+    journal_broadcast(&record);
+}
+
+// 发送心跳，备机据此判断主机存活并计算序号差
+void journal_heartbeat() {
+    int64_t now = now_us();
+    if (replication.standby_count == 0 || now - replication.last_heartbeat_us < JOURNAL_HEARTBEAT_MS * 1000) {
+        return;
+    }
+    replication.last_heartbeat_us = now;
+    
+    JournalRecord record;
+    memset(&record, 0, sizeof(record));
+    record.op = JOURNAL_HEARTBEAT;
+    record.magic = JOURNAL_MAGIC;
+    record.lsn = replication.lsn;
+    record.sent_at_us = now;
+    for (int i = replication.standby_count - 1; i >= 0; i--) {
+        journal_send(i, &record);
+    }
+}
+
+// 关闭所有复制连接
+void replication_close() {
+    for (int i = 0; i < replication.standby_count; i++) {
+        close(replication.standby_fds[i]);
+    }
+    replication.standby_count = 0;
+    
+    if (replication.listen_fd >= 0) {
+        close(replication.listen_fd);
+        replication.listen_fd = -1;
+        unlink(JOURNAL_SOCKET_PATH);
+    }
+}
+
+// 等待菜单输入，同时推进定时任务（自动保存等）；启用复制时接受备机连接和发送心跳
+void wait_for_input() {
+    fflush(stdout);
+    
+    for (;;) {
+        struct pollfd fds[2];
+        fds[0].fd = STDIN_FILENO;
+        fds[0].events = POLLIN;
+        fds[1].fd = replication.listen_fd;
+        fds[1].events = POLLIN;
+        
+        if (poll(fds, 2, JOURNAL_HEARTBEAT_MS) < 0 && errno != EINTR) return;
+        
+        if (fds[1].revents & POLLIN) {
+            replication_accept();
+        }
+        
+        timer_advance(time(NULL));
+        journal_flush();
+        journal_heartbeat();
+        
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) return;
+    }
+}
+
+// 备机应用一条日志记录
+void apply_journal_record(const JournalRecord* record) {
+    if (record->op == JOURNAL_DELETE) {
+        delete_room_from_list(record->room.room_number);
+        return;
+    }
+    
+    apply_room_image(&record->room, &record->guest);
+}
+
+// 读取一条完整记录，连接关闭或出错返回0
+static int journal_receive(int fd, JournalRecord* record) {
+    char* data = (char*)record;
+    size_t left = sizeof(JournalRecord);
+    
+    while (left > 0) {
+        ssize_t n = recv(fd, data, left, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        data += n;
+        left -= n;
+    }
+    return record->magic == JOURNAL_MAGIC;
+}
+
+static void print_standby_stats(const StandbyStats* stats) {
+    printf("\n=== 复制状态 ===\n");
+    printf("房间数: %d\n", slot_table.room_count);
+    printf("已应用日志序号: %llu\n", (unsigned long long)stats->applied_lsn);
+    printf("主机日志序号: %llu\n", (unsigned long long)stats->primary_lsn);
+    printf("已应用记录数: %llu\n", (unsigned long long)stats->records);
+    printf("最近复制延迟: %lld 微秒\n", (long long)stats->last_lag_us);
+    printf("最大复制延迟: %lld 微秒\n", (long long)stats->max_lag_us);
+    if (stats->records > 0) {
+        printf("平均复制延迟: %lld 微秒\n", (long long)(stats->total_lag_us / (int64_t)stats->records));
+    }
+    if (stats->last_received_us > 0) {
+        printf("距上次收到主机消息: %lld 毫秒\n", (long long)((now_us() - stats->last_received_us) / 1000));
+    }
+}
+
+// 备机主循环：应用主机日志，响应查看状态和提升命令
+// 提升为主机返回1，退出返回0
+int run_standby() {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", JOURNAL_SOCKET_PATH);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror("无法连接主机");
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    
+    // 先加载主机持久化的客人表，提升后历史入住记录中的guest_id仍然有效
+    guest_store_load();
+    
+    setvbuf(stdin, NULL, _IONBF, 0);
+    printf("备机模式：已连接主机 %s\n", JOURNAL_SOCKET_PATH);
+    printf("1. 复制状态  2. 提升为主机  0. 退出\n");
+    fflush(stdout);
+    
+    StandbyStats stats;
+    memset(&stats, 0, sizeof(stats));
+    int connected = 1;
+    
+    for (;;) {
+        struct pollfd fds[2];
+        fds[0].fd = STDIN_FILENO;
+        fds[0].events = POLLIN;
+        fds[1].fd = connected ? fd : -1;
+        fds[1].events = POLLIN;
+        
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            JournalRecord record;
+            if (!journal_receive(fd, &record)) {
+                printf("与主机的连接已断开，可输入2提升为主机\n");
+                fflush(stdout);
+                connected = 0;
+                continue;
+            }
+            
+            int64_t received = now_us();
+            stats.last_received_us = received;
+            if (record.op == JOURNAL_HEARTBEAT) {
+                stats.primary_lsn = record.lsn;
+                continue;
+            }
+            
+            apply_journal_record(&record);
+            int64_t lag = now_us() - record.sent_at_us;
+            stats.applied_lsn = record.lsn;
+            if (record.lsn > stats.primary_lsn) stats.primary_lsn = record.lsn;
+            stats.records++;
+            stats.last_lag_us = lag;
+            stats.total_lag_us += lag;
+            if (lag > stats.max_lag_us) stats.max_lag_us = lag;
+        }
+        
+        if (fds[0].revents & (POLLIN | POLLHUP)) {
+            int choice = -1;
+            if (scanf("%d", &choice) != 1) choice = 0;
+            getchar();
+            
+            if (choice == 1) {
+                print_standby_stats(&stats);
+            } else if (choice == 2) {
+                close(fd);
+                return 1;
+            } else if (choice == 0) {
+                break;
+            }
+            fflush(stdout);
+        }
+    }
+    
+    close(fd);
+    return 0;
+}
+
+// 用房间镜像创建或覆盖内存中的房间，客人按身份证号映射到本机guest_id
+void apply_room_image(const Room* image, const Guest* guest) {
+    Room* room = find_room(image->room_number);
+    if (room == NULL) {
+        room = create_room(image->room_number, image->type, image->price_per_night);
+        if (room == NULL) return;
+        add_room_to_list(room);
+    }
+    
+    ordered_index_remove(room);
+    room->type = image->type;
+    room->status = image->status;
+    room->price_per_night = image->price_per_night;
+    room->guest_id = guest->id_card[0] != '\0' ? guest_upsert(guest) : 0;
+    room->check_in_time = image->check_in_time;
+    room->check_out_time = image->check_out_time;
+    room->expected_check_out_time = image->expected_check_out_time;
+    room->is_checked_out = image->is_checked_out;
+    room->lock = image->lock;
+    ordered_index_add(room);
+    room_touch(room);
+}
+
+// MySQL后端：连接数据库
+static int mysql_storage_open() {
+    mysql_conn = connect_database();
+    return mysql_conn != NULL;
+}
+
+static void mysql_storage_close() {
+    if (mysql_conn) {
+        mysql_close(mysql_conn);
+        mysql_conn = NULL;
+    }
+}
+
+// MySQL后端：批量写入使用一个事务
+static void mysql_storage_begin() {
+    if (mysql_conn != NULL) mysql_autocommit(mysql_conn, 0);
+}
+
+static void mysql_storage_commit() {
+    if (mysql_conn == NULL) return;
+    if (mysql_commit(mysql_conn) != 0) {
+        printf("数据库提交失败: %s\n", mysql_error(mysql_conn));
+    }
+    mysql_autocommit(mysql_conn, 1);
+}
+
+// 键值存储：写出日志中每个房间的最终状态（用于压缩）
+static int kv_write_table(FILE* file) {
+    KvRecord record;
+    long count = 0;
+    
+    RoomSnapshot* snapshot = snapshot_acquire();
+    for (int slot = 0; snapshot != NULL && slot < snapshot->slot_count; slot++) {
+        const Room* current = snapshot_room(snapshot, slot);
+        if (current == NULL) continue;
+        
+        memset(&record, 0, sizeof(record));
+        record.magic = KV_STORE_MAGIC;
+        record.op = KV_PUT;
+        record.updated_at = time(NULL);
+        record.room = *current;
+        record.room.next = NULL;
+        record.room.dirty = 0;
+        guest_get(current->guest_id, &record.guest);
+        if (fwrite(&record, sizeof(record), 1, file) != 1) {
+            snapshot_release(snapshot);
+            return -1;
+        }
+        count++;
+    }
+    snapshot_release(snapshot);
+    
+    kv_store.records = count;
+    return 0;
+}
+
+// 键值存储：打开日志文件用于追加
+static int kv_storage_open() {
+    kv_store.file = fopen(KV_STORE_PATH, "ab");
+    if (kv_store.file == NULL) {
+        perror("键值存储打开失败");
+        return 0;
+    }
+    kv_store.in_batch = 0;
+    return 1;
+}
+
+// 键值存储：关闭时把日志压缩为每个房间一条记录
+static void kv_storage_close() {
+    if (kv_store.file == NULL) return;
+    fclose(kv_store.file);
+    kv_store.file = NULL;
+    
+    FILE* file = fopen(KV_STORE_PATH ".tmp", "wb");
+    if (file == NULL) {
+        perror("键值存储压缩失败");
+        return;
+    }
+    
+    int failed = kv_write_table(file) != 0;
+    failed |= fflush(file) != 0 || fsync(fileno(file)) != 0;
+    failed |= fclose(file) != 0;
+    if (failed || rename(KV_STORE_PATH ".tmp", KV_STORE_PATH) != 0) {
+        perror("键值存储压缩失败");
+        unlink(KV_STORE_PATH ".tmp");
+    }
+}
+
+// 键值存储：记录落盘，批量写入时推迟到提交
+static void kv_sync() {
+    if (kv_store.file == NULL || kv_store.in_batch) return;
+    if (fflush(kv_store.file) != 0 || fdatasync(fileno(kv_store.file)) != 0) {
+        perror("键值存储写入失败");
+    }
+}
+
+static void kv_append(KvOp op, const Room* room, int room_number) {
+    if (kv_store.file == NULL) return;
+    
+    KvRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic = KV_STORE_MAGIC;
+    record.op = op;
+    record.updated_at = time(NULL);
+    if (room != NULL) {
+        record.room = *room;
+        record.room.next = NULL;
+        record.room.dirty = 0;
+        guest_get(room->guest_id, &record.guest);
+    } else {
+        record.room.room_number = room_number;
+    }
+    
+    if (fwrite(&record, sizeof(record), 1, kv_store.file) != 1) {
+        perror("键值存储写入失败");
+        return;
+    }
+    kv_store.records++;
+    kv_sync();
+}
+
+static void kv_storage_insert(const Room* room) {
+    kv_append(KV_PUT, room, room->room_number);
+}
+
+static void kv_storage_update(const Room* room) {
+    kv_append(KV_PUT, room, room->room_number);
+}
+
+static void kv_storage_remove(int room_number) {
+    kv_append(KV_DELETE, NULL, room_number);
+}
+
+static void kv_storage_begin() {
+    kv_store.in_batch = 1;
+}
+
+static void kv_storage_commit() {
+    kv_store.in_batch = 0;
+    kv_sync();
+}
+
+static int compare_kv_entry(const void* a, const void* b) {
+    const KvEntry* x = (const KvEntry*)a;
+    const KvEntry* y = (const KvEntry*)b;
+    if (x->room_number != y->room_number) {
+        return x->room_number < y->room_number ? -1 : 1;
+    }
+    return x->seq < y->seq ? -1 : (x->seq > y->seq);
+}
+
+// 键值存储：第一遍只读记录头确定每个房间的最终记录，第二遍按序号读取完整记录
+// 快照中不存在的房间直接创建；日志记录比快照新时覆盖或删除内存中的记录
+static int kv_storage_load(time_t snapshot_time) {
+    FILE* file = fopen(KV_STORE_PATH, "rb");
+    if (file == NULL) return -1;
+    
+    KvEntry* entries = NULL;
+    long count = 0;
+    long capacity = 0;
+    KvRecord record;
+    
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        if (record.magic != KV_STORE_MAGIC) {
+            printf("键值存储记录损坏，忽略第 %ld 条之后的记录\n", count);
+            break;
+        }
+        if (count == capacity) {
+            long new_capacity = capacity ? capacity * 2 : 1024;
+            KvEntry* grown = (KvEntry*)realloc(entries, new_capacity * sizeof(KvEntry));
+            if (grown == NULL) {
+                printf("内存分配失败\n");
+                free(entries);
+                fclose(file);
+                return -1;
+            }
+            entries = grown;
+            capacity = new_capacity;
+        }
+        entries[count].room_number = record.room.room_number;
+        entries[count].op = record.op;
+        entries[count].updated_at = record.updated_at;
+        entries[count].seq = count;
+        count++;
+    }
+    
+    if (count > 1) {
+        qsort(entries, count, sizeof(KvEntry), compare_kv_entry);
+    }
+    
+    int applied = 0;
+    for (long i = 0; i < count; i++) {
+        // 同一房间只处理最后一条记录
+        if (i + 1 < count && entries[i + 1].room_number == entries[i].room_number) continue;
+        
+        KvEntry* entry = &entries[i];
+        Room* room = find_room(entry->room_number);
+        if (room != NULL && entry->updated_at <= snapshot_time) {
+            continue; // 快照已是最新
+        }
+        
+        if (entry->op == KV_DELETE) {
+            if (room != NULL) {
+                delete_room_from_list(entry->room_number);
+                applied++;
+            }
+            continue;
+        }
+        
+        if (fseek(file, entry->seq * (long)sizeof(KvRecord), SEEK_SET) != 0 ||
+            fread(&record, sizeof(record), 1, file) != 1) {
+            printf("键值存储读取失败\n");
+            break;
+        }
+        apply_room_image(&record.room, &record.guest);
+        applied++;
+    }
+    
+    kv_store.records = count;
+    free(entries);
+    fclose(file);
+    return applied;
+}
+
+// 内存后端：不持久化，用于压测时排除数据库开销
+static int memory_storage_open() {
+    return 1;
+}
+
+static void memory_storage_close() {
+}
+
+static int memory_storage_load(time_t snapshot_time) {
+    (void)snapshot_time;
+    return 0;
+}
+
+static void memory_storage_insert(const Room* room) {
+    (void)room;
+}
+
+static void memory_storage_update(const Room* room) {
+    (void)room;
+}
+
+static void memory_storage_remove(int room_number) {
+    (void)room_number;
+}
+
+static void memory_storage_batch() {
+}
+
+static const StorageBackend storage_backends[] = {
+    {"mysql", mysql_storage_open, mysql_storage_close, warm_start_from_database,
+     mysql_storage_insert, mysql_storage_update, mysql_storage_remove,
+     mysql_storage_begin, mysql_storage_commit},
+    {"kv", kv_storage_open, kv_storage_close, kv_storage_load,
+     kv_storage_insert, kv_storage_update, kv_storage_remove,
+     kv_storage_begin, kv_storage_commit},
+    {"memory", memory_storage_open, memory_storage_close, memory_storage_load,
+     memory_storage_insert, memory_storage_update, memory_storage_remove,
+     memory_storage_batch, memory_storage_batch},
+};
+
+// 按名称查找持久化后端
+const StorageBackend* find_storage(const char* name) {
+    for (size_t i = 0; i < sizeof(storage_backends) / sizeof(storage_backends[0]); i++) {
+        if (strcmp(storage_backends[i].name, name) == 0) {
+            return &storage_backends[i];
+        }
+    }
+    return NULL;
+}
+
+// 把房间加入修改集合
+void changeset_add(ChangeSet* set, Room* room) {
+    if (room->dirty & set->bit) return;
+    
+    if (set->count == set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : 256;
+        Room** rooms = (Room**)realloc(set->rooms, capacity * sizeof(Room*));
+        if (rooms == NULL) {
+            printf("内存分配失败\n");
+            return;
+        }
+        set->rooms = rooms;
+        set->capacity = capacity;
+    }
+    set->rooms[set->count++] = room;
+    room->dirty |= set->bit;
+}
+
+// 从修改集合中移除房间
+void changeset_remove(ChangeSet* set, Room* room) {
+    if (!(room->dirty & set->bit)) return;
+    
+    for (int i = 0; i < set->count; i++) {
+        if (set->rooms[i] == room) {
+            set->rooms[i] = set->rooms[--set->count];
+            break;
+        }
+    }
+    room->dirty &= ~set->bit;
+}
+
+// 清空修改集合
+void changeset_clear(ChangeSet* set) {
+    for (int i = 0; i < set->count; i++) {
+        set->rooms[i]->dirty &= ~set->bit;
+    }
+    set->count = 0;
+}
+
+void changeset_free(ChangeSet* set) {
+    free(set->rooms);
+    set->rooms = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
+
+// 房间即将释放：移出所有修改集合，记下需要写入空记录的槽位
+void room_forget(Room* room) {
+    changeset_remove(&replication.changes, room);
+    changeset_remove(&save_state.file_changes, room);
+    changeset_remove(&save_state.db_changes, room);
+    
+    if (room->slot < 0) return;
+    if (save_state.freed_count == save_state.freed_capacity) {
+        int capacity = save_state.freed_capacity ? save_state.freed_capacity * 2 : 64;
+        int* slots = (int*)realloc(save_state.freed_slots, capacity * sizeof(int));
+        if (slots == NULL) {
+            // 无法记录时下次保存整体重写
+            save_state.layout_valid = 0;
+            return;
+        }
+        save_state.freed_slots = slots;
+        save_state.freed_capacity = capacity;
+    }
+    save_state.freed_slots[save_state.freed_count++] = room->slot;
+}
+
+// 时间对应的本地日期序号
+static int local_day(time_t t, long utc_offset) {
+    int64_t local = (int64_t)t + utc_offset;
+    return (int)(local >= 0 ? local / 86400 : (local - 86399) / 86400);
+}
+
+// 把一段入住[start_day, end_day)累加到差分数组，超出窗口的部分截掉
+static void analytics_add_stay(int32_t* diff, int base_day, int days, RoomType type, int start_day, int end_day) {
+    if ((int)type < 1 || (int)type > ROOM_TYPE_COUNT) return;
+    if (end_day <= start_day) end_day = start_day + 1; // 当天入住当天退房按一晚计
+    
+    int start = start_day - base_day;
+    int end = end_day - base_day;
+    if (start < 0) start = 0;
+    if (end > days) end = days;
+    if (start >= end) return;
+    
+    int32_t* row = diff + (type - 1) * (days + 1);
+    row[start]++;
+    row[end]--;
+}
+
+// 分析工作线程：按块读取负责范围内的退房记录，只累计差分数组，不保留记录
+static void* analytics_worker(void* arg) {
+    AnalyticsTask* task = (AnalyticsTask*)arg;
+    StayRecord* block = (StayRecord*)malloc(ANALYTICS_BLOCK * sizeof(StayRecord));
+    if (block == NULL) {
+        task->failed = 1;
+        return NULL;
+    }
+    
+    for (long index = task->first; index < task->last; ) {
+        long n = task->last - index;
+        if (n > ANALYTICS_BLOCK) n = ANALYTICS_BLOCK;
+        
+        ssize_t bytes = pread(task->fd, block, n * sizeof(StayRecord), (off_t)index * sizeof(StayRecord));
+        if (bytes < (ssize_t)sizeof(StayRecord)) {
+            task->failed = bytes < 0;
+            break;
+        }
+        n = bytes / sizeof(StayRecord);
+        
+        for (long i = 0; i < n; i++) {
+            const StayRecord* stay = &block[i];
+            if (stay->check_in_time <= 0 || stay->check_out_time < stay->check_in_time) continue;
+            analytics_add_stay(task->diff, task->base_day, task->days, stay->type,
+                               local_day(stay->check_in_time, task->utc_offset),
+                               local_day(stay->check_out_time, task->utc_offset));
+            task->stays++;
+        }
+        index += n;
+    }
+    
+    free(block);
+    return NULL;
+}
+
+// 统计截至now的每日售出间夜数：退房归档按记录范围分给多个线程，再加上当前在住的房间
+// 成功返回1，失败返回0；report->nights由调用者释放
+int run_occupancy_analysis(time_t now, OccupancyReport* report) {
+    memset(report, 0, sizeof(OccupancyReport));
+    
+    struct tm tm_now = *localtime(&now);
+    long utc_offset = tm_now.tm_gmtoff;
+    int today = local_day(now, utc_offset);
+    int days = ANALYTICS_HISTORY_DAYS;
+    report->base_day = today - days + 1;
+    report->days = days;
+    
+    long total = 0;
+    int fd = open("checked_out_rooms.dat", O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0) total = st.st_size / sizeof(StayRecord);
+    }
+    
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cpus > 0 ? (int)cpus : 1;
+    if (workers > ANALYTICS_MAX_WORKERS) workers = ANALYTICS_MAX_WORKERS;
+    // 每个线程至少处理一个读取块
+    if (workers > (total + ANALYTICS_BLOCK - 1) / ANALYTICS_BLOCK) {
+        workers = total > 0 ? (int)((total + ANALYTICS_BLOCK - 1) / ANALYTICS_BLOCK) : 1;
+    }
+    
+    AnalyticsTask tasks[ANALYTICS_MAX_WORKERS];
+    memset(tasks, 0, sizeof(tasks));
+    pthread_t threads[ANALYTICS_MAX_WORKERS];
+    int started[ANALYTICS_MAX_WORKERS] = {0};
+    long per_worker = (total + workers - 1) / workers;
+    size_t diff_size = (size_t)ROOM_TYPE_COUNT * (days + 1);
+    int ok = 1;
+    
+    for (int w = 0; w < workers; w++) {
+        AnalyticsTask* task = &tasks[w];
+        task->fd = fd;
+        task->first = w * per_worker;
+        task->last = task->first + per_worker;
+        if (task->first > total) task->first = total;
+        if (task->last > total) task->last = total;
+        task->base_day = report->base_day;
+        task->days = days;
+        task->utc_offset = utc_offset;
+        task->diff = (int32_t*)calloc(diff_size, sizeof(int32_t));
+        if (task->diff == NULL) {
+            ok = 0;
+            break;
+        }
+        
+        // 第一个分区在当前线程执行
+        if (w > 0) {
+            if (pthread_create(&threads[w], NULL, analytics_worker, task) != 0) {
+                ok = 0;
+                break;
+            }
+            started[w] = 1;
+        }
+    }
+    
+    if (ok) analytics_worker(&tasks[0]);
+    
+    for (int w = 0; w < workers; w++) {
+        if (started[w]) pthread_join(threads[w], NULL);
+        if (tasks[w].failed) ok = 0;
+    }
+    if (fd >= 0) close(fd);
+    
+    if (ok) {
+        report->nights = (uint32_t*)malloc((size_t)ROOM_TYPE_COUNT * days * sizeof(uint32_t));
+        ok = report->nights != NULL;
+    }
+    
+    if (ok) {
+        // 合并到第一个线程的差分数组
+        int32_t* diff = tasks[0].diff;
+        for (int w = 1; w < workers; w++) {
+            for (size_t i = 0; i < diff_size; i++) diff[i] += tasks[w].diff[i];
+            report->stays += tasks[w].stays;
+        }
+        report->stays += tasks[0].stays;
+        
+        // 当前在住的房间从入住日计到今晚
+        RoomSnapshot* snapshot = snapshot_acquire();
+        for (int slot = 0; snapshot != NULL && slot < snapshot->slot_count; slot++) {
+            const Room* room = snapshot_room(snapshot, slot);
+            if (room == NULL || (int)room->type < 1 || (int)room->type > ROOM_TYPE_COUNT) continue;
+            report->rooms[room->type - 1]++;
+            if (room->status == OCCUPIED && room->check_in_time > 0) {
+                analytics_add_stay(diff, report->base_day, days, room->type,
+                                   local_day(room->check_in_time, utc_offset), today + 1);
+            }
+        }
+        snapshot_release(snapshot);
+        
+        report->first_day = today;
+        for (int t = 0; t < ROOM_TYPE_COUNT; t++) {
+            int32_t running = 0;
+            for (int d = 0; d < days; d++) {
+                running += diff[t * (days + 1) + d];
+                report->nights[t * days + d] = running > 0 ? (uint32_t)running : 0;
+                if (running > 0 && report->base_day + d < report->first_day) {
+                    report->first_day = report->base_day + d;
+                }
+            }
+        }
+    }
+    
+    for (int w = 0; w < workers; w++) free(tasks[w].diff);
+    if (!ok) {
+        free(report->nights);
+        report->nights = NULL;
+    }
+    return ok;
+}
+
+// 日期序号对应的月份（0-11）
+static int day_month(int day) {
+    time_t t = (time_t)day * 86400;
+    struct tm tm_day;
+    gmtime_r(&t, &tm_day);
+    return tm_day.tm_mon;
+}
+
+// 日期序号对应的星期（0为星期日）
+static int day_weekday(int day) {
+    return ((day % 7) + 7 + 4) % 7; // 1970-01-01是星期四
+}
+
+// 月份所在季节：0春(3-5月) 1夏(6-8月) 2秋(9-11月) 3冬(12-2月)
+static int month_season(int month) {
+    return ((month + 10) % 12) / 3;
+}
+
+// 按显示宽度左对齐输出（汉字占两列）
+static void print_padded(const char* text, int width) {
+    int columns = 0;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        if (*p < 0x80) columns++;
+        else if (*p >= 0xC0) columns += 2;
+    }
+    printf("%s%*s", text, width > columns ? width - columns : 0, "");
+}
+
+// 打印入住率热力图和下月需求预测
+void print_occupancy_report(const OccupancyReport* report) {
+    static const char* weekday_names[7] = {"周日", "周一", "周二", "周三", "周四", "周五", "周六"};
+    static const char* season_names[4] = {"春", "夏", "秋", "冬"};
+    int days = report->days;
+    int today = report->base_day + days - 1;
+    int first = report->first_day - report->base_day;
+    
+    printf("扫描退房记录 %ld 条，分析 %d 天（含今天）\n", report->stays, days - first);
+    
+    // 窗口内每天的星期、月份只算一次
+    unsigned char* weekday = (unsigned char*)malloc(days);
+    unsigned char* month = (unsigned char*)malloc(days);
+    if (weekday == NULL || month == NULL) {
+        printf("内存分配失败\n");
+        free(weekday);
+        free(month);
+        return;
+    }
+    for (int d = first; d < days; d++) {
+        weekday[d] = (unsigned char)day_weekday(report->base_day + d);
+        month[d] = (unsigned char)day_month(report->base_day + d);
+    }
+    
+    printf("\n--- 入住率：房型 x 星期 ---\n");
+    print_padded("房型", 12);
+    for (int w = 1; w <= 7; w++) {
+        printf("  ");
+        print_padded(weekday_names[w % 7], 6);
+    }
+    printf("\n");
+    for (int t = 0; t < ROOM_TYPE_COUNT; t++) {
+        print_padded(get_room_type_name((RoomType)(t + 1)), 12);
+        uint64_t nights[7] = {0};
+        int count[7] = {0};
+        for (int d = first; d < days; d++) {
+            nights[weekday[d]] += report->nights[t * days + d];
+            count[weekday[d]]++;
+        }
+        for (int w = 1; w <= 7; w++) {
+            int k = w % 7;
+            if (report->rooms[t] == 0 || count[k] == 0) {
+                printf("%8s", "-");
+            } else {
+                printf("%7.1f%%", 100.0 * nights[k] / ((double)report->rooms[t] * count[k]));
+            }
+        }
+        printf("\n");
+    }
+    
+    printf("\n--- 入住率：房型 x 季节 ---\n");
+    print_padded("房型", 12);
+    for (int k = 0; k < 4; k++) {
+        printf("  ");
+        print_padded(season_names[k], 6);
+    }
+    printf("\n");
+    for (int t = 0; t < ROOM_TYPE_COUNT; t++) {
+        print_padded(get_room_type_name((RoomType)(t + 1)), 12);
+        uint64_t nights[4] = {0};
+        int count[4] = {0};
+        for (int d = first; d < days; d++) {
+            int k = month_season(month[d]);
+            nights[k] += report->nights[t * days + d];
+            count[k]++;
+        }
+        for (int k = 0; k < 4; k++) {
+            if (report->rooms[t] == 0 || count[k] == 0) {
+                printf("%8s", "-");
+            } else {
+                printf("%7.1f%%", 100.0 * nights[k] / ((double)report->rooms[t] * count[k]));
+            }
+        }
+        printf("\n");
+    }
+    
+    // 预测：最近几周同一星期几的平均间夜数作基线，乘以目标月份相对全年平均的季节系数
+    printf("\n--- 未来 %d 天需求预测 ---\n", FORECAST_DAYS);
+    print_padded("房型", 12);
+    print_padded("预计间夜", 10);
+    print_padded("入住率", 10);
+    printf("需求最高日\n");
+    for (int t = 0; t < ROOM_TYPE_COUNT; t++) {
+        const uint32_t* row = report->nights + t * days;
+        uint64_t month_nights[12] = {0};
+        int month_days[12] = {0};
+        uint64_t all_nights = 0;
+        for (int d = first; d < days; d++) {
+            month_nights[month[d]] += row[d];
+            month_days[month[d]]++;
+            all_nights += row[d];
+        }
+        double overall = days > first ? (double)all_nights / (days - first) : 0.0;
+        
+        double demand = 0.0;
+        double peak = -1.0;
+        int peak_day = today + 1;
+        for (int f = 1; f <= FORECAST_DAYS; f++) {
+            int target = today + f;
+            
+            double base = 0.0;
+            int samples = 0;
+            for (int back = target - 7; back > today - FORECAST_WEEKS * 7 && samples < FORECAST_WEEKS; back -= 7) {
+                if (back > today) continue;
+                int d = back - report->base_day;
+                if (d < first) break;
+                base += row[d];
+                samples++;
+            }
+            if (samples > 0) base /= samples;
+            
+            int m = day_month(target);
+            double factor = 1.0;
+            if (overall > 0 && month_days[m] > 0) {
+                factor = (double)month_nights[m] / month_days[m] / overall;
+            }
+            
+            double predicted = base * factor;
+            if (predicted > report->rooms[t]) predicted = report->rooms[t];
+            demand += predicted;
+            if (predicted > peak) {
+                peak = predicted;
+                peak_day = target;
+            }
+        }
+        
+        print_padded(get_room_type_name((RoomType)(t + 1)), 12);
+        char rate[16] = "-";
+        if (report->rooms[t] > 0) {
+            snprintf(rate, sizeof(rate), "%.1f%%", 100.0 * demand / ((double)report->rooms[t] * FORECAST_DAYS));
+        }
+        printf("%-10.0f%-10s", demand, rate);
+        time_t peak_time = (time_t)peak_day * 86400;
+        struct tm tm_peak;
+        gmtime_r(&peak_time, &tm_peak);
+        char date[16];
+        strftime(date, sizeof(date), "%Y-%m-%d", &tm_peak);
+        printf("%s\n", date);
+    }
+    
+    free(weekday);
+    free(month);
+}
+
+// 入住分析功能
+void occupancy_analytics() {
+    printf("\n=== 入住分析 ===\n");
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    OccupancyReport report;
+    if (!run_occupancy_analysis(time(NULL), &report)) {
+        printf("入住分析失败\n");
+        return;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    print_occupancy_report(&report);
+    printf("\n分析耗时 %.3f 秒\n",
+           (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+    
+    free(report.nights);
+}
\ No newline at end of file